@@ -1,9 +1,9 @@
 #include "GameMode.hpp"
 
 #include "Sprites.hpp"
+#include "parsing/sprite_ids.hpp"
 #include "Load.hpp"
 #include "data_path.hpp"
-#include "read_write_chunk.hpp"
 
 // for the GL_ERRORS() macro:
 #include "gl_errors.hpp"
@@ -11,7 +11,12 @@
 // for glm::value_ptr() :
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
-#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <array>
+#include <chrono>
 
 #include <random>
 #include <time.h>
@@ -35,54 +40,64 @@ Sprite const *player_right = nullptr;
 Sprite const *flower = nullptr;
 Sprite const *void_puddle = nullptr;
 
-Sprite const *background_tile1 = nullptr;
-Sprite const *background_tile2 = nullptr;
-Sprite const *background_tile3 = nullptr;
 Sprite const *void_tile = nullptr;
 
-Load<Sprites> sprites(LoadTagDefault, []() -> Sprites const *
-					  {
-	static Sprites ret = Sprites::load(data_path("../parsing/sprites"));
+// Background of every round, compiled from sprites/level.map.png
+Map const *level_map = nullptr;
+
+// The sprites the pointers above point into
+Sprites const *bound_sprites = nullptr;
+
+// Points all the game sprites into the given sprites
+static void bind_sprites(Sprites const &from)
+{
+	bound_sprites = &from;
+
+	player_idle = &from[SpriteID::player];
+	player_up = &from[SpriteID::player_up];
+	player_down = &from[SpriteID::player_down];
+	player_left = &from[SpriteID::player_left];
+	player_right = &from[SpriteID::player_right];
 
-	player_idle = &ret.lookup("player");
-	player_up = &ret.lookup("player_up");
-	player_down = &ret.lookup("player_down");
-	player_left = &ret.lookup("player_left");
-	player_right = &ret.lookup("player_right");
+	flower = &from[SpriteID::flower];
+	void_puddle = &from[SpriteID::void_puddle];
 
-	flower = &ret.lookup("flower");
-	void_puddle = &ret.lookup("void_puddle");
+	void_tile = &from[SpriteID::void_];
 
-	background_tile1 = &ret.lookup("background1");
-	background_tile2 = &ret.lookup("background2");
-	background_tile3 = &ret.lookup("background3");
-	void_tile = &ret.lookup("void");
+	level_map = &from[MapID::level];
+}
 
+Load<Sprites> sprites(LoadTagDefault, []() -> Sprites const *
+					  {
+	// The sprites are compiled into the game, so no file has to be read
+	static Sprites ret = Sprites::embedded();
+	bind_sprites(ret);
 	return &ret; });
 
-// Define the indexes of the first tile of each sprite in the sprite table
-constexpr int PLAYER = 0;
-constexpr int FLOWER = 1;
+// Sprites loaded from parsing/assets.ppu when it changes while the game runs
+static Sprites reloaded_sprites;
 
-GameMode::GameMode()
+// Archive written by parsing/parse_ppm, watched for hot reloading
+static std::string assets_path()
 {
-	// Updating palette table and tile table
-	std::vector<PPU466::Palette> palette_table;
-	std::vector<PPU466::Tile> tile_table;
+	return data_path("../parsing/assets.ppu");
+}
 
-	std::ifstream file(data_path("../parsing/tables.ppu"));
+uint32_t GameMode::seed = 0;
 
-	read_chunk(file, "tile", &tile_table);
-	read_chunk(file, "palt", &palette_table);
+// Define the indexes of the first tile of each sprite in the sprite table
+constexpr int PLAYER = 0;
+constexpr int FLOWER = 1;
 
-	for (size_t i = 0; i < palette_table.size(); i++)
-	{
-		ppu.palette_table[i] = palette_table[i];
-	}
+GameMode::GameMode(bool hot_reload_) : hot_reload(hot_reload_)
+{
+	load_tables(*bound_sprites);
 
-	for (size_t i = 0; i < tile_table.size(); i++)
+	if (hot_reload)
 	{
-		ppu.tile_table[i] = tile_table[i];
+		// Only changes made to the archive from now on are reloaded
+		std::error_code error;
+		assets_time = std::filesystem::last_write_time(assets_path(), error);
 	}
 
 	// Put all the game sprites into the sprite table
@@ -96,6 +111,210 @@ GameMode::~GameMode()
 {
 }
 
+void GameMode::load_tables(Sprites const &from)
+{
+	// The pipeline should fail before producing tables that don't fit in the PPU, but check anyway
+	if (from.palette_table.size() > ppu.palette_table.size())
+	{
+		throw std::runtime_error("The assets hold " + std::to_string(from.palette_table.size()) + " palettes but the PPU only has room for " + std::to_string(ppu.palette_table.size()));
+	}
+	if (from.tile_table.size() > ppu.tile_table.size())
+	{
+		throw std::runtime_error("The assets hold " + std::to_string(from.tile_table.size()) + " tiles but the PPU only has room for " + std::to_string(ppu.tile_table.size()));
+	}
+
+	for (size_t i = 0; i < from.palette_table.size(); i++)
+	{
+		ppu.palette_table[i] = from.palette_table[i];
+	}
+
+	for (size_t i = 0; i < from.tile_table.size(); i++)
+	{
+		ppu.tile_table[i] = from.tile_table[i];
+	}
+}
+
+// Loads the archive at the given path and checks it can replace the current sprites without restarting the game.
+// Only reads the current sprites, which are not swapped out while it runs, so it can run on another thread.
+static Sprites load_assets(std::string const &path, Sprites const *current, size_t tile_capacity, size_t palette_capacity)
+{
+	Sprites loaded = Sprites::load(path);
+	// The game state knows how many sprite table entries each sprite takes, so sprites can't change size
+	// (the archive holds the sprites and maps listed in sprite_ids.hpp, so there are as many as before)
+	for (size_t i = 0; i < loaded.sprites.size(); i++)
+	{
+		if (loaded.sprites[i].tiles.size() != current->sprites[i].tiles.size())
+		{
+			throw std::runtime_error("sprite '" + std::string(loaded.sprites[i].name) + "' changed size, restart the game to use it");
+		}
+	}
+	for (size_t i = 0; i < loaded.maps.size(); i++)
+	{
+		if (loaded.maps[i].width != current->maps[i].width || loaded.maps[i].height != current->maps[i].height)
+		{
+			throw std::runtime_error("map '" + std::string(loaded.maps[i].name) + "' changed size, restart the game to use it");
+		}
+	}
+	if (loaded.tile_table.size() > tile_capacity || loaded.palette_table.size() > palette_capacity)
+	{
+		throw std::runtime_error("the tables don't fit in the PPU");
+	}
+	return loaded;
+}
+
+void GameMode::check_assets(float elapsed)
+{
+	if (!hot_reload)
+	{
+		return;
+	}
+
+	// Loading and checking the archive reads and checksums the whole file, so it is done on another thread
+	// and only the swap happens here, between two frames
+	if (loading_assets.valid())
+	{
+		if (loading_assets.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return;
+		}
+		Sprites loaded;
+		try
+		{
+			loaded = loading_assets.get();
+		}
+		catch (std::exception const &e)
+		{
+			std::cerr << ANSI_COLOR_RED << "Not reloading the assets: " << e.what() << ANSI_COLOR_RESET << std::endl;
+			return;
+		}
+		swap_assets(std::move(loaded));
+		return;
+	}
+
+	// Checking the file costs a system call, so it is only done a few times per second
+	assets_check_timer -= elapsed;
+	if (assets_check_timer > 0.0f)
+	{
+		return;
+	}
+	assets_check_timer = 0.25f;
+
+	std::error_code error;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(assets_path(), error);
+	if (error || time == assets_time)
+	{
+		return;
+	}
+	assets_time = time;
+
+	loading_assets = std::async(std::launch::async, load_assets, assets_path(), bound_sprites, ppu.tile_table.size(), ppu.palette_table.size());
+}
+
+void GameMode::swap_assets(Sprites &&loaded)
+{
+	// Compared before the swap, since level_map points into the current sprites
+	bool map_changed = !std::equal(level_map->tiles.begin(), level_map->tiles.end(), loaded[MapID::level].tiles.begin(), loaded[MapID::level].tiles.end());
+
+	// Sprite table entries the game state knows the sprite of, refreshed from that sprite below
+	std::array<bool, std::tuple_size_v<decltype(ppu.sprites)>> owned = {};
+	owned[PLAYER] = true;
+	for (int flower_index : flowers)
+	{
+		for (size_t i = 0; i < flower->tiles.size(); i++)
+		{
+			owned[flower_index + i] = true;
+		}
+	}
+	for (int puddle_index : void_puddles)
+	{
+		for (size_t i = 0; i < void_puddle->tiles.size(); i++)
+		{
+			owned[puddle_index + i] = true;
+		}
+	}
+
+	// Any other entry is mapped from its (tile, palette) pair to the pair of the same tile of the reloaded sprites.
+	// Sprites can share a pair before the reload but not after, so such pairs are left as they are.
+	auto pair = [](uint32_t tile_index, uint32_t palette_index)
+	{
+		return tile_index | (palette_index << 8);
+	};
+	std::unordered_map<uint32_t, uint32_t> remap;
+	std::unordered_set<uint32_t> conflicts;
+	for (size_t i = 0; i < loaded.sprites.size(); i++)
+	{
+		for (size_t j = 0; j < loaded.sprites[i].tiles.size(); j++)
+		{
+			Sprite::TileRef const &before = bound_sprites->sprites[i].tiles[j];
+			Sprite::TileRef const &after = loaded.sprites[i].tiles[j];
+			auto [found, added] = remap.emplace(pair(before.tile_index, before.palette_index), pair(after.tile_index, after.palette_index));
+			if (!added && found->second != pair(after.tile_index, after.palette_index))
+			{
+				conflicts.insert(found->first);
+			}
+		}
+	}
+	size_t unmapped = 0;
+	for (size_t i = 0; i < ppu.sprites.size(); i++)
+	{
+		if (owned[i])
+		{
+			continue;
+		}
+		PPU466::Sprite &sprite = ppu.sprites[i];
+		uint32_t key = pair(sprite.index, sprite.attributes & 0x07);
+		if (conflicts.count(key))
+		{
+			unmapped++;
+			continue;
+		}
+		auto found = remap.find(key);
+		if (found != remap.end())
+		{
+			// Sprites keep their other attributes
+			sprite.index = uint8_t(found->second);
+			sprite.attributes = uint8_t((sprite.attributes & ~0x07) | (found->second >> 8));
+		}
+	}
+
+	load_tables(loaded);
+	reloaded_sprites = std::move(loaded);
+	bind_sprites(reloaded_sprites);
+
+	// The player's entry is set from its sprite every update
+	auto refresh = [this](int first, Sprite const *sprite)
+	{
+		for (size_t i = 0; i < sprite->tiles.size(); i++)
+		{
+			ppu.sprites[first + i].index = sprite->tiles[i].tile_index;
+			ppu.sprites[first + i].attributes = uint8_t((ppu.sprites[first + i].attributes & ~0x07) | sprite->tiles[i].palette_index);
+		}
+	};
+	for (int flower_index : flowers)
+	{
+		refresh(flower_index, flower);
+	}
+	for (int puddle_index : void_puddles)
+	{
+		refresh(puddle_index, void_puddle);
+	}
+
+	// The background is the map until the void takes over, which draw() fills again every frame
+	if (map_changed && death_timer > 0)
+	{
+		level_map->copy_to(ppu.background);
+	}
+
+	if (unmapped)
+	{
+		std::cerr << ANSI_COLOR_YELLOW << "Reloaded the assets, but " << unmapped << " sprite table entries share a tile with several sprites and were left as they are" << ANSI_COLOR_RESET << std::endl;
+	}
+	else
+	{
+		std::cout << ANSI_COLOR_GREEN << "Reloaded the assets" << ANSI_COLOR_RESET << std::endl;
+	}
+}
+
 void GameMode::setup_map(uint8_t nb_flowers, uint8_t nb_puddles, uint16_t death_time)
 {
 	current_flowers = nb_flowers;
@@ -105,14 +324,14 @@ void GameMode::setup_map(uint8_t nb_flowers, uint8_t nb_puddles, uint16_t death_
 	flowers = {};
 	void_puddles = {};
 
-	srand((unsigned)time(NULL));
+	rng.seed(seed ? seed + round : uint32_t(time(NULL)));
 
 	int nb_tiles = FLOWER;
 	for (int i = 0; i < nb_flowers; i++)
 	{
 		flowers.push_back(nb_tiles);
-		int flower_x = rand() % (256 - 3 * tile_size);
-		int flower_y = rand() % (240 - 2 * tile_size);
+		int flower_x = rng() % (256 - 3 * tile_size);
+		int flower_y = rng() % (240 - 2 * tile_size);
 		for (Sprite::TileRef tile_ref : flower->tiles)
 		{
 			ppu.sprites[nb_tiles].index = tile_ref.tile_index;
@@ -126,8 +345,8 @@ void GameMode::setup_map(uint8_t nb_flowers, uint8_t nb_puddles, uint16_t death_
 	for (int i = 0; i < nb_puddles; i++)
 	{
 		void_puddles.push_back(nb_tiles);
-		int puddle_x = rand() % (256 - 2 * tile_size);
-		int puddle_y = rand() % (240 - 2 * tile_size);
+		int puddle_x = rng() % (256 - 2 * tile_size);
+		int puddle_y = rng() % (240 - 2 * tile_size);
 		for (Sprite::TileRef tile_ref : void_puddle->tiles)
 		{
 			ppu.sprites[nb_tiles].index = tile_ref.tile_index;
@@ -138,13 +357,8 @@ void GameMode::setup_map(uint8_t nb_flowers, uint8_t nb_puddles, uint16_t death_
 		}
 	}
 
-	// Setting the background to the background tiles
-	Sprite const *background_sprites[3] = {background_tile1, background_tile2, background_tile3};
-	for (unsigned int i = 0; i < ppu.BackgroundWidth * ppu.BackgroundHeight; i++)
-	{
-		int rand_background = rand() % 3;
-		ppu.background[i] = background_sprites[rand_background]->tiles[0].tile_index + (background_sprites[rand_background]->tiles[0].palette_index << 8);
-	}
+	// The map is already in the PPU's layout, so it is copied as is
+	level_map->copy_to(ppu.background);
 }
 
 bool GameMode::colide(uint8_t obj1_x, uint8_t obj1_y, uint8_t obj1_size, uint8_t obj2_x, uint8_t obj2_y, uint8_t obj2_size)
@@ -228,6 +442,9 @@ bool GameMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 
 void GameMode::update(float elapsed)
 {
+	// Swap in new assets between frames if they were rebuilt
+	check_assets(elapsed);
+
 	death_timer--;
 	// Player movement and animation
 	constexpr float PlayerSpeed = 50.0f;
@@ -1,13 +1,18 @@
 #include "PPU466.hpp"
 #include "Mode.hpp"
+#include "Sprites.hpp"
 
 #include <glm/glm.hpp>
 
 #include <vector>
 #include <deque>
+#include <filesystem>
+#include <future>
+#include <random>
 
 struct GameMode : Mode {
-	GameMode();
+	// hot_reload watches parsing/assets.ppu for changes while the game runs (a development feature, see --hot-reload)
+	GameMode(bool hot_reload = false);
 	virtual ~GameMode();
 
 	//functions called by main loop:
@@ -52,6 +57,11 @@ struct GameMode : Mode {
 	// Number of rounds played
 	uint16_t round = 0;
 
+	// When not 0, every round places its flowers and puddles from this seed instead of the clock,
+	// so runs can be compared (see --seed in main.cpp)
+	static uint32_t seed;
+	std::mt19937 rng;
+
 	// Function to detect the collision between two objects based on their position and size
 	// Both objects should be squares, it is meant to be used on tiles
 	static bool colide(uint8_t obj1_x, uint8_t obj1_y, uint8_t obj1_size, uint8_t obj2_x, uint8_t obj2_y, uint8_t obj2_size);
@@ -59,6 +69,25 @@ struct GameMode : Mode {
 	// Sets up the map
 	void setup_map(uint8_t nb_flowers, uint8_t nb_puddles, uint16_t death_time);
 
+	//----- hot reload -----
+
+	// Copies the tile and palette tables of the given sprites to the PPU
+	void load_tables(Sprites const &from);
+
+	// Only when hot_reload is set: checks parsing/assets.ppu for changes a few times per second
+	// (see parsing/parse_ppm --watch), loads and checks a changed archive on another thread,
+	// and swaps it in between two frames once it is ready, keeping the game state
+	void check_assets(float elapsed);
+
+	// Swaps the tables and sprites of a loaded archive in, updating the sprite table and background to match
+	void swap_assets(Sprites &&loaded);
+
+	bool const hot_reload;
+	float assets_check_timer = 0.0f;
+	std::filesystem::file_time_type assets_time = {};
+	// The archive being loaded, if any
+	std::future<Sprites> loading_assets;
+
 	//----- drawing handled by PPU466 -----
 
 	PPU466 ppu;
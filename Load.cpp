@@ -5,19 +5,23 @@
 #include <cassert>
 
 namespace {
-	std::array< std::list< std::function< void() > >, MaxLoadTag > &get_load_lists() {
-		static std::array< std::list< std::function< void() > >, MaxLoadTag > load_lists;
+	struct LoadFunction {
+		std::function< void() > fn;
+		LoadNeeds needs;
+	};
+	std::array< std::list< LoadFunction >, MaxLoadTag > &get_load_lists() {
+		static std::array< std::list< LoadFunction >, MaxLoadTag > load_lists;
 		return load_lists;
 	}
 }
 
-void add_load_function(LoadTag tag, std::function< void() > const &fn) {
+void add_load_function(LoadTag tag, std::function< void() > const &fn, LoadNeeds needs) {
 	auto &load_lists = get_load_lists();
 	assert(tag < load_lists.size());
-	load_lists[tag].emplace_back(fn);
+	load_lists[tag].emplace_back(LoadFunction{fn, needs});
 }
 
-void call_load_functions() {
+void call_load_functions(bool with_gl) {
 	static bool has_been_called = false;
 	assert(!has_been_called && "call_load_functions should only be called *once*");
 	has_been_called = true;
@@ -25,7 +29,9 @@ void call_load_functions() {
 	auto &load_lists = get_load_lists();
 	for (auto &fn_list : load_lists) {
 		while (!fn_list.empty()) {
-			(*fn_list.begin())(); //call first function in the list
+			if (with_gl || fn_list.begin()->needs != LoadNeedsGL) {
+				fn_list.begin()->fn(); //call first function in the list
+			}
 			fn_list.pop_front(); //remove from list
 		}
 	}
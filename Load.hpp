@@ -33,14 +33,22 @@ enum LoadTag : uint32_t {
 	MaxLoadTag //<-- just used to track # of load tags
 };
 
+//What a loading function needs in order to run:
+enum LoadNeeds : uint32_t {
+	LoadNeedsNothing,
+	LoadNeedsGL, //<-- an OpenGL context (e.g., to create shader programs or textures)
+};
+
 //Add a function to an internal list of loading functions:
 // (only call *before* "call_load_functions()")
-void add_load_function(LoadTag tag, std::function< void() > const &fn);
+void add_load_function(LoadTag tag, std::function< void() > const &fn, LoadNeeds needs = LoadNeedsNothing);
 
 //Call all loading functions:
 // (loading functions may throw exceptions if they fail.)
 // (only call *once*)
-void call_load_functions();
+// (when there is no OpenGL context -- e.g., main.cpp's --headless mode -- pass with_gl = false
+//  to skip the functions that need one; the Load<>s they would have loaded stay null.)
+void call_load_functions(bool with_gl = true);
 
 
 //work-around for MSVC not accepting this as a lambda:
@@ -50,13 +58,13 @@ T const *new_T() { return new T; }
 template< typename T >
 struct Load {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >) : value(nullptr) {
+	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >, LoadNeeds needs = LoadNeedsNothing) : value(nullptr) {
 		add_load_function(tag, [this,load_fn](){
 			this->value = load_fn();
 			if (!(this->value)) {
 				throw std::runtime_error("Loading failed.");
 			}
-		});
+		}, needs);
 	}
 
 	//Make a "Load< T >" behave like a "T const *":
@@ -74,8 +82,8 @@ struct Load {
 template< >
 struct Load< void > {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load( LoadTag tag, const std::function< void() > &load_fn) {
-		add_load_function(tag, load_fn);
+	Load( LoadTag tag, const std::function< void() > &load_fn, LoadNeeds needs = LoadNeedsNothing) {
+		add_load_function(tag, load_fn, needs);
 	}
 };
 
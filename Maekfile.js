@@ -31,6 +31,7 @@ if (maek.OS === "windows") {
 		`/I${NEST_LIBS}/SDL3/include`,
 		`/I${NEST_LIBS}/glm/include`,
 		`/I${NEST_LIBS}/libpng/include`,
+		`/I${NEST_LIBS}/zlib/include`,
 		//#disable a few warnings:
 		`/wd4146`, //-1U is still unsigned
 		`/wd4297`, //unforunately SDLmain is nothrow
@@ -50,7 +51,8 @@ if (maek.OS === "windows") {
 		//include paths for nest libraries:
 		`-I${NEST_LIBS}/SDL3/include`, `-D_THREAD_SAFE`,
 		`-I${NEST_LIBS}/glm/include`,
-		`-I${NEST_LIBS}/libpng/include`
+		`-I${NEST_LIBS}/libpng/include`,
+		`-I${NEST_LIBS}/zlib/include`
 	);
 	maek.options.LINKLibs.push(
 		//linker flags for nest libraries:
@@ -64,7 +66,8 @@ if (maek.OS === "windows") {
 		//include paths for nest libraries:
 		`-I${NEST_LIBS}/SDL3/include`, `-D_THREAD_SAFE`,
 		`-I${NEST_LIBS}/glm/include`,
-		`-I${NEST_LIBS}/libpng/include`
+		`-I${NEST_LIBS}/libpng/include`,
+		`-I${NEST_LIBS}/zlib/include`
 	);
 	maek.options.LINKLibs.push(
 		//linker flags for nest libraries:
@@ -115,7 +118,10 @@ const game_objs = [
 	maek.CPP('PlayMode.cpp'),
 	maek.CPP('GameMode.cpp'),
 	maek.CPP('Sprites.cpp'),
+	maek.CPP('mapped_file.cpp'),
+	maek.CPP('parsing/embedded_assets.cpp'),
 	maek.CPP('PPU466.cpp'),
+	maek.CPP('PPU466_software.cpp'),
 	maek.CPP('main.cpp'),
 	maek.CPP('load_save_png.cpp'),
 	maek.CPP('Load.cpp'),
@@ -126,7 +132,9 @@ const game_objs = [
 ];
 
 const utility_objs = [
-  maek.CPP('parse_ppm.cpp')
+  maek.CPP('parse_ppm.cpp'),
+  maek.CPP('mapped_file.cpp'),
+  maek.CPP('load_save_png.cpp')
 ];
 const utility_exe = maek.LINK(utility_objs, 'parsing/parse_ppm');
 
@@ -8,6 +8,10 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <vector>
+#include <array>
+#include <iostream>
+#include <cstring>
+#include <string>
 
 //In order to implement the PPU466 on modern graphics hardware, a fancy, special purpose tile-drawing shader is used:
 struct PPUTileProgram {
@@ -30,7 +34,48 @@ struct PPUTileProgram {
 };
 
 //Initialize tile program and associated buffers:
-Load< PPUTileProgram > tile_program(LoadTagEarly); //will 'new PPUTileProgram()' by default
+Load< PPUTileProgram > tile_program(LoadTagEarly, new_T< PPUTileProgram >, LoadNeedsGL); //(not loaded when running headless -- see PPU466::headless)
+
+//The same tiles can be drawn without any vertex data: this program's vertex shader builds the quads
+// from the vertex index, reading the background and sprites directly from buffer textures:
+struct PPUPullProgram {
+	PPUPullProgram();
+	~PPUPullProgram();
+
+	GLuint program = 0;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint CHUNK_POSITIONS_ivec2_4 = -1U; //lower-left corner of each quarter of the background (see background_chunk_positions)
+	GLuint LAYER_int = -1U; //0 to draw the background, 1 for the 'behind' sprites, 2 for the 'in front' sprites
+
+	//Textures bindings:
+	//TEXTURE0 - the tile table (as a 128x128 R8UI texture)
+	//TEXTURE1 - the palette table (as a 4x8 RGBA8 texture)
+	//TEXTURE2 - the background (as a 64*60 R16UI buffer texture)
+	//TEXTURE3 - the sprites (as a 64 RGBA8UI buffer texture: x, y, index, attributes)
+};
+
+Load< PPUPullProgram > pull_program(LoadTagEarly, new_T< PPUPullProgram >, LoadNeedsGL);
+
+//Shader program that draws the whole background with one triangle, looking up the tile under each pixel:
+struct PPUTilemapProgram {
+	PPUTilemapProgram();
+	~PPUTilemapProgram();
+
+	GLuint program = 0;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint BACKGROUND_POSITION_ivec2 = -1U; //background_position, reduced to [0,BackgroundWidth*8)x[0,BackgroundHeight*8)
+
+	//Textures bindings:
+	//TEXTURE0 - the tile table (as a 128x128 R8UI texture)
+	//TEXTURE1 - the palette table (as a 4x8 RGBA8 texture)
+	//TEXTURE4 - the background (as a 64x60 R16UI texture)
+};
+
+Load< PPUTilemapProgram > tilemap_program(LoadTagEarly, new_T< PPUTilemapProgram >, LoadNeedsGL);
 
 //PPU data is streamed to the GPU (read: uploaded 'just in time') using a few buffers:
 struct PPUDataStream {
@@ -59,9 +104,31 @@ struct PPUDataStream {
 
 	//texture object that will store palette table:
 	GLuint palette_tex = 0;
+
+	//buffers (and the buffer textures that read them) that store the background and sprites as they are, for vertex pulling:
+	GLuint background_buffer = 0;
+	GLuint background_tex = 0;
+	GLuint sprites_buffer = 0;
+	GLuint sprites_tex = 0;
+
+	//texture object that stores the background, one texel per tile, for the tilemap program:
+	GLuint background_map_tex = 0;
+
+	//vertex array object without any attributes, for vertex pulling:
+	GLuint empty_vertex_array = 0;
+
+	//copies of the tables as last uploaded, so draw() only uploads what changed:
+	// (the textures are shared by every PPU466, so these live here rather than in the PPU;
+	//  they are 'mutable' because draw() keeps them in sync with the textures through a const Load<>)
+	mutable bool uploaded = false;
+	mutable std::array< PPU466::Tile, 16 * 16 > uploaded_tile_table;
+	mutable std::array< PPU466::Palette, 8 > uploaded_palette_table;
+
+	//contents of tile_tex, one color index per texel (only the tiles that changed are re-expanded):
+	mutable std::array< uint8_t, 128 * 128 > tile_image;
 };
 
-Load< PPUDataStream > data_stream(LoadTagDefault);
+Load< PPUDataStream > data_stream(LoadTagDefault, new_T< PPUDataStream >, LoadNeedsGL);
 
 //-------------------------------------------------------------------
 
@@ -86,7 +153,58 @@ PPU466::PPU466() {
 	}
 }
 
+//To simulate the 'infinite tiling' behavior, the background is drawn as four screen-sized chunks
+// (lower left, lower right, upper left, upper right quarter of the background),
+// each of which is drawn at an offset that causes it to overlap the screen.
+//This computes the lower-left corner of each chunk on the screen:
+static std::array< glm::ivec2, 4 > background_chunk_positions(glm::ivec2 const &background_position) {
+	static_assert(PPU466::BackgroundWidth * 8 == PPU466::ScreenWidth * 2, "Background should be exactly twice the screen width.");
+	static_assert(PPU466::BackgroundHeight * 8 == PPU466::ScreenHeight * 2, "Background should be exactly twice the screen height.");
+
+	std::array< glm::ivec2, 4 > positions;
+	for (int32_t chunk_y : {0, int32_t(PPU466::ScreenHeight)}) {
+		for (int32_t chunk_x : {0, int32_t(PPU466::ScreenWidth)}) {
+			//position of the lower-left corner of the chunk:
+			glm::ivec2 pos = glm::ivec2(chunk_x, chunk_y) + background_position;
+
+			constexpr int32_t BackgroundWidthPixels = int32_t(PPU466::BackgroundWidth) * 8;
+			constexpr int32_t BackgroundHeightPixels = int32_t(PPU466::BackgroundHeight) * 8;
+
+			//reduce to (-BackgroundWidthPixels,0] x (-BackgroundHeightPixels,0]:
+			pos.x = ((pos.x % BackgroundWidthPixels) - BackgroundWidthPixels) % BackgroundWidthPixels;
+			pos.y = ((pos.y % BackgroundHeightPixels) - BackgroundHeightPixels) % BackgroundHeightPixels;
+
+			//move chunk if it doesn't overlap the screen:
+			if (pos.x + int32_t(PPU466::ScreenWidth) <= 0) pos.x += BackgroundWidthPixels;
+			if (pos.y + int32_t(PPU466::ScreenHeight) <= 0) pos.y += BackgroundHeightPixels;
+
+			positions[(chunk_y ? 2 : 0) + (chunk_x ? 1 : 0)] = pos;
+		}
+	}
+	return positions;
+}
+
+//transform from [0,ScreenWidth]x[0,ScreenHeight] -> [-1,1]x[-1,1], used by both tile-drawing programs:
+static glm::mat4 object_to_clip() {
+	//NOTE: glm uses column-major matrices:
+	return glm::mat4(
+		glm::vec4(2.0f / float(PPU466::ScreenWidth), 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 2.0f / float(PPU466::ScreenHeight), 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-1.0f,-1.0f, 0.0f, 1.0f)
+	);
+}
+
+bool PPU466::headless = false;
+std::vector< glm::u8vec4 > *PPU466::headless_frame = nullptr;
+
 void PPU466::draw(glm::uvec2 const &drawable_size) const {
+	if (headless) {
+		//there is no OpenGL context, so draw on the CPU (if anyone wants the frame):
+		if (headless_frame) draw_software(headless_frame);
+		return;
+	}
+
 	//this code does screen scaling by manipulating the viewport, so save old values:
 	GLint old_viewport[4];
 	glGetIntegerv(GL_VIEWPORT, old_viewport);
@@ -120,6 +238,86 @@ void PPU466::draw(glm::uvec2 const &drawable_size) const {
 		glViewport(lower_left.x, lower_left.y, scale * ScreenWidth, scale * ScreenHeight);
 	}
 
+	//-------------------------------------------------
+	//Upload the tables to the GPU using PPUDataStream (the same for every renderer):
+
+	{ //upload palette texture, if it changed:
+		static_assert(sizeof(palette_table) == 4 * 4 * decltype(palette_table)().size(), "palette table is packed");
+		if (!data_stream->uploaded || std::memcmp(data_stream->uploaded_palette_table.data(), palette_table.data(), sizeof(palette_table)) != 0) {
+			glBindTexture(GL_TEXTURE_2D, data_stream->palette_tex);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 4, GLsizei(palette_table.size()), GL_RGBA, GL_UNSIGNED_BYTE, palette_table.data());
+			glBindTexture(GL_TEXTURE_2D, 0);
+			data_stream->uploaded_palette_table = palette_table;
+		}
+	}
+
+	{ //update + upload the tiles that changed in the tile table texture:
+		//the tile table texture is a 128 x 128 index texture, a 16x16 grid of 8x8 tiles:
+		std::array< uint8_t, 128 * 128 > &data = data_stream->tile_image;
+
+		std::vector< uint32_t > dirty;
+		for (uint32_t i = 0; i < tile_table.size(); ++i) {
+			if (data_stream->uploaded && std::memcmp(&data_stream->uploaded_tile_table[i], &tile_table[i], sizeof(Tile)) == 0) continue;
+			dirty.emplace_back(i);
+
+			Tile const &tile = tile_table[i];
+			data_stream->uploaded_tile_table[i] = tile;
+
+			//location of tile in the texture:
+			uint32_t ox = (i % 16) * 8;
+			uint32_t oy = (i / 16) * 8;
+
+			//copy tile indices into texture:
+			for (uint32_t y = 0; y < 8; ++y) {
+				for (uint32_t x = 0; x < 8; ++x) {
+					data[ox+x + 128 * (oy+y)] =
+						  ((tile.bit0[y] >> x) & 1)
+						| ((tile.bit1[y] >> x) & 1) << 1;
+				}
+			}
+		}
+
+		if (!dirty.empty()) {
+			glBindTexture(GL_TEXTURE_2D, data_stream->tile_tex);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			if (dirty.size() <= 16) {
+				//a few tiles changed (e.g., an animated tile): upload just their 8x8 regions
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, 128);
+				for (uint32_t i : dirty) {
+					uint32_t ox = (i % 16) * 8;
+					uint32_t oy = (i / 16) * 8;
+					glTexSubImage2D(GL_TEXTURE_2D, 0, ox, oy, 8, 8, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data() + ox + 128 * oy);
+				}
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+			} else {
+				//many tiles changed (e.g., the tables were loaded): upload every row of tiles between the first and last changed ones at once
+				uint32_t first_row = dirty.front() / 16;
+				uint32_t last_row = dirty.back() / 16;
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first_row * 8, 128, (last_row - first_row + 1) * 8, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data() + 128 * first_row * 8);
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+
+		data_stream->uploaded = true;
+	}
+
+	//draw the background and sprites:
+	if (renderer == Renderer::VertexPulling || renderer == Renderer::Tilemap) {
+		draw_vertex_pulling();
+	} else {
+		draw_triangle_strip();
+	}
+
+	//also restore viewport, since earlier scaling code messed with it:
+	glViewport(old_viewport[0], old_viewport[1], old_viewport[2], old_viewport[3]);
+
+	GL_ERRORS();
+}
+
+
+
+void PPU466::draw_triangle_strip() const {
 	//build triangle strip representing background and sprites:
 
 	constexpr uint32_t TristripSize = uint32_t(6 * (BackgroundWidth * BackgroundHeight + decltype(sprites)().size()));
@@ -157,25 +355,11 @@ void PPU466::draw(glm::uvec2 const &drawable_size) const {
 	{ //draw the background:
 		//To simulate the 'infinite tiling' behavior this code draws the background as four screen-sized chunks,
 		// each of which is drawn at an offset that causes it to overlap the screen.
-
-		static_assert(BackgroundWidth * 8 == ScreenWidth * 2, "Background should be exactly twice the screen width.");
-		static_assert(BackgroundHeight * 8 == ScreenHeight * 2, "Background should be exactly twice the screen height.");
-
+		std::array< glm::ivec2, 4 > chunk_positions = background_chunk_positions(background_position);
 		for (int32_t chunk_y : {0, int32_t(ScreenHeight)}) {
 			for (int32_t chunk_x : {0, int32_t(ScreenWidth)}) {
 				//position of the lower-left corner of the chunk:
-				glm::ivec2 pos = glm::ivec2(chunk_x, chunk_y) + background_position;
-
-				constexpr int32_t BackgroundWidthPixels = int32_t(BackgroundWidth) * 8;
-				constexpr int32_t BackgroundHeightPixels = int32_t(BackgroundHeight) * 8;
-
-				//reduce to (-BackgroundWidthPixels,0] x (-BackgroundHeightPixels,0]:
-				pos.x = ((pos.x % BackgroundWidthPixels) - BackgroundWidthPixels) % BackgroundWidthPixels;
-				pos.y = ((pos.y % BackgroundHeightPixels) - BackgroundHeightPixels) % BackgroundHeightPixels;
-
-				//move chunk if it doesn't overlap the screen:
-				if (pos.x + int32_t(ScreenWidth) <= 0) pos.x += BackgroundWidthPixels;
-				if (pos.y + int32_t(ScreenHeight) <= 0) pos.y += BackgroundHeightPixels;
+				glm::ivec2 pos = chunk_positions[(chunk_y ? 2 : 0) + (chunk_x ? 1 : 0)];
 
 				int32_t ox = chunk_x / 8;
 				int32_t oy = chunk_y / 8;
@@ -198,41 +382,6 @@ void PPU466::draw(glm::uvec2 const &drawable_size) const {
 
 	assert(triangle_strip.size() == TristripSize && "Triangle strip size was estimated exactly.");
 
-	//-------------------------------------------------
-	//Upload at to GPU using PPUDataStream:
-
-	{ //upload palette texture:
-		static_assert(sizeof(palette_table) == 4 * 4 * decltype(palette_table)().size(), "palette table is packed");
-		glBindTexture(GL_TEXTURE_2D, data_stream->palette_tex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 4, GLsizei(palette_table.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, palette_table.data());
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-
-	{ //build + upload tile table texture:
-		//interpret tiles and build a 128 x 128 index texture:
-		static std::array< uint8_t, 128 * 128 > data;
-		for (uint32_t i = 0; i < tile_table.size(); ++i) {
-			Tile const &tile = tile_table[i];
-
-			//location of tile in the texture:
-			uint32_t ox = (i % 16) * 8;
-			uint32_t oy = (i / 16) * 8;
-
-			//copy tile indices into texture:
-			for (uint32_t y = 0; y < 8; ++y) {
-				for (uint32_t x = 0; x < 8; ++x) {
-					data[ox+x + 128 * (oy+y)] =
-						  ((tile.bit0[y] >> x) & 1)
-						| ((tile.bit1[y] >> x) & 1) << 1;
-				}
-			}
-		}
-
-		glBindTexture(GL_TEXTURE_2D, data_stream->tile_tex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, 128, 128, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data());
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-
 	{ //upload vertex data:
 		glBindBuffer(GL_ARRAY_BUFFER, data_stream->vertex_buffer);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(decltype(triangle_strip[0])) * triangle_strip.size(), triangle_strip.data(), GL_STREAM_DRAW);
@@ -253,13 +402,7 @@ void PPU466::draw(glm::uvec2 const &drawable_size) const {
 
 	// set uniforms for shader programs:
 	{ //set matrix to transform [0,ScreenWidth]x[0,ScreenHeight] -> [-1,1]x[-1,1]:
-		//NOTE: glm uses column-major matrices:
-		glm::mat4 OBJECT_TO_CLIP = glm::mat4(
-			glm::vec4(2.0f / float(ScreenWidth), 0.0f, 0.0f, 0.0f),
-			glm::vec4(0.0f, 2.0f / float(ScreenHeight), 0.0f, 0.0f),
-			glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
-			glm::vec4(-1.0f,-1.0f, 0.0f, 1.0f)
-		);
+		glm::mat4 OBJECT_TO_CLIP = object_to_clip();
 		glUniformMatrix4fv(tile_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(OBJECT_TO_CLIP));
 	}
 
@@ -282,16 +425,179 @@ void PPU466::draw(glm::uvec2 const &drawable_size) const {
 	glUseProgram(0);
 
 	glDisable(GL_BLEND);
+}
 
-	//also restore viewport, since earlier scaling code messed with it:
-	glViewport(old_viewport[0], old_viewport[1], old_viewport[2], old_viewport[3]);
+bool PPU466::check_renderers() {
+	std::vector< glm::u8vec4 > expected;
+	draw_software(&expected);
+
+	//draw at 1x scale into a framebuffer of our own, so the window size doesn't matter:
+	GLint old_framebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &old_framebuffer);
+	GLuint framebuffer = 0, color = 0;
+	glGenRenderbuffers(1, &color);
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, ScreenWidth, ScreenHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+
+	Renderer const old_renderer = renderer;
+	std::array< std::pair< Renderer, char const * >, 3 > const renderers{{
+		{Renderer::TriangleStrip, "TriangleStrip"},
+		{Renderer::VertexPulling, "VertexPulling"},
+		{Renderer::Tilemap, "Tilemap"},
+	}};
+	bool same = true;
+	for (auto const &[check, name] : renderers) {
+		renderer = check;
+		draw(glm::uvec2(ScreenWidth, ScreenHeight));
+		std::vector< glm::u8vec4 > pixels(ScreenWidth * ScreenHeight);
+		glReadPixels(0, 0, ScreenWidth, ScreenHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+		//(the framebuffer's alpha isn't shown, so only the colors are compared)
+		uint32_t differing = 0;
+		for (uint32_t i = 0; i < pixels.size(); ++i) {
+			if (pixels[i].r != expected[i].r || pixels[i].g != expected[i].g || pixels[i].b != expected[i].b) ++differing;
+		}
+		std::cout << name << ": " << differing << " pixels differ from draw_software." << std::endl;
+		same = same && (differing == 0);
+	}
+	renderer = old_renderer;
 
+	glBindFramebuffer(GL_FRAMEBUFFER, old_framebuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &color);
 	GL_ERRORS();
+
+	return same;
 }
 
+void PPU466::draw_vertex_pulling() const {
+	//the tilemap renderer draws the background with its own program (sprites are drawn the same way either way):
+	bool const tilemap = (renderer == Renderer::Tilemap);
+
+	{ //upload the background and sprites as they are:
+		static_assert(sizeof(background) == 2 * BackgroundWidth * BackgroundHeight, "background is packed");
+		static_assert(sizeof(sprites) == 4 * decltype(sprites)().size(), "sprites are packed");
+		if (tilemap) {
+			//rows of the background are 128 bytes, so the default unpack alignment is fine:
+			glBindTexture(GL_TEXTURE_2D, data_stream->background_map_tex);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, BackgroundWidth, BackgroundHeight, GL_RED_INTEGER, GL_UNSIGNED_SHORT, background.data());
+			glBindTexture(GL_TEXTURE_2D, 0);
+		} else {
+			glBindBuffer(GL_TEXTURE_BUFFER, data_stream->background_buffer);
+			glBufferData(GL_TEXTURE_BUFFER, sizeof(background), background.data(), GL_STREAM_DRAW);
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, data_stream->sprites_buffer);
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(sprites), sprites.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	//set up the pipeline:
+	// set blending function for output fragments:
+	glEnable(GL_BLEND);
+	glBlendEquation(GL_FUNC_ADD);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// set the shader programs:
+	glUseProgram(pull_program->program);
+
+	// no attribute streams (the vertex shader builds every vertex from gl_VertexID), but core profile needs a vertex array object bound:
+	glBindVertexArray(data_stream->empty_vertex_array);
+
+	// set uniforms for shader programs:
+	{ //set matrix to transform [0,ScreenWidth]x[0,ScreenHeight] -> [-1,1]x[-1,1]:
+		glm::mat4 OBJECT_TO_CLIP = object_to_clip();
+		glUniformMatrix4fv(pull_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(OBJECT_TO_CLIP));
+	}
+	{ //set where each quarter of the background is drawn:
+		std::array< glm::ivec2, 4 > chunk_positions = background_chunk_positions(background_position);
+		GLint positions[8];
+		for (uint32_t i = 0; i < 4; ++i) {
+			positions[2*i+0] = chunk_positions[i].x;
+			positions[2*i+1] = chunk_positions[i].y;
+		}
+		glUniform2iv(pull_program->CHUNK_POSITIONS_ivec2_4, 4, positions);
+	}
+
+	// bind texture units to proper texture objects:
+	glActiveTexture(GL_TEXTURE4);
+	glBindTexture(GL_TEXTURE_2D, data_stream->background_map_tex);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_BUFFER, data_stream->sprites_tex);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_BUFFER, data_stream->background_tex);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, data_stream->palette_tex);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, data_stream->tile_tex);
+
+	//now that the pipeline is configured, draw six vertices (two triangles) per tile,
+	// in the same order as the triangle strip: 'behind' sprites, background, 'in front' sprites
+	constexpr GLsizei SpriteVertices = GLsizei(6 * decltype(sprites)().size());
+	constexpr GLsizei BackgroundVertices = GLsizei(6 * BackgroundWidth * BackgroundHeight);
+	glUniform1i(pull_program->LAYER_int, 1);
+	glDrawArrays(GL_TRIANGLES, 0, SpriteVertices);
+	if (tilemap) {
+		//one triangle that covers the screen (and twice as much again, which is clipped away);
+		// the fragment shader finds the background texel under each pixel, so the cost doesn't depend on scrolling:
+		glUseProgram(tilemap_program->program);
+		glm::mat4 OBJECT_TO_CLIP = object_to_clip();
+		glUniformMatrix4fv(tilemap_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(OBJECT_TO_CLIP));
+		//reduce position here, since GLSL's '%' is undefined for negative numbers:
+		constexpr int32_t BackgroundWidthPixels = int32_t(BackgroundWidth) * 8;
+		constexpr int32_t BackgroundHeightPixels = int32_t(BackgroundHeight) * 8;
+		glUniform2i(tilemap_program->BACKGROUND_POSITION_ivec2,
+			((background_position.x % BackgroundWidthPixels) + BackgroundWidthPixels) % BackgroundWidthPixels,
+			((background_position.y % BackgroundHeightPixels) + BackgroundHeightPixels) % BackgroundHeightPixels
+		);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glUseProgram(pull_program->program);
+	} else {
+		glUniform1i(pull_program->LAYER_int, 0);
+		glDrawArrays(GL_TRIANGLES, 0, BackgroundVertices);
+	}
+	glUniform1i(pull_program->LAYER_int, 2);
+	glDrawArrays(GL_TRIANGLES, 0, SpriteVertices);
+
+	//return state to default:
+	glActiveTexture(GL_TEXTURE4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	glDisable(GL_BLEND);
+}
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+//fragment shader shared by both tile-drawing programs:
+static char const *TileFragmentShader =
+	"#version 330\n"
+	"uniform usampler2D TILE_TABLE;\n"
+	"uniform sampler2D PALETTE_TABLE;\n"
+	"in vec2 tileCoord;\n"
+	"flat in int palette;\n" //"flat" means "uses the value of the provoking [by default, last] vertex in the primitive"
+	"out vec4 fragColor;\n"
+	"void main() {\n"
+	"	uint index = texelFetch(TILE_TABLE, ivec2(tileCoord), 0).r;\n"
+	"	fragColor = texelFetch(PALETTE_TABLE, ivec2(index, palette), 0);\n"
+	//"	fragColor = vec4(float(index)/4.0,float(palette)/8,1,1);\n"
+	//"	fragColor = texelFetch(TILE_TABLE, ivec2(int(gl_FragCoord.x) % textureSize(TILE_TABLE,0).x, int(gl_FragCoord.y) % textureSize(TILE_TABLE,0).y), 0);\n"
+	//"	fragColor = texelFetch(PALETTE_TABLE, ivec2(int(gl_FragCoord.x) % textureSize(PALETTE_TABLE,0).x, int(gl_FragCoord.y) % textureSize(PALETTE_TABLE,0).y), 0);\n"
+	"}\n";
+
 PPUTileProgram::PPUTileProgram() {
 	program = gl_compile_program(
 		//vertex shader:
@@ -307,44 +613,159 @@ PPUTileProgram::PPUTileProgram() {
 		"	tileCoord = TileCoord;\n"
 		"	palette = Palette;\n"
 		"}\n"
+	,
+		TileFragmentShader
+	);
+
+	//look up the locations of vertex attributes:
+	Position_vec2 = glGetAttribLocation(program, "Position");
+	TileCoord_ivec2 = glGetAttribLocation(program, "TileCoord");
+	Palette_int = glGetAttribLocation(program, "Palette");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+
+	GLuint TILE_TABLE_usampler2D = glGetUniformLocation(program, "TILE_TABLE");
+	GLuint PALETTE_TABLE_sampler2D = glGetUniformLocation(program, "PALETTE_TABLE");
+
+	//bind texture units indices to samplers:
+	glUseProgram(program);
+	glUniform1i(TILE_TABLE_usampler2D, 0);
+	glUniform1i(PALETTE_TABLE_sampler2D, 1);
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
+
+PPUTileProgram::~PPUTileProgram() {
+	if (program != 0) {
+		glDeleteProgram(program);
+		program = 0;
+	}
+}
+
+PPUPullProgram::PPUPullProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"uniform ivec2 CHUNK_POSITIONS[4];\n"
+		"uniform int LAYER;\n"
+		"uniform usamplerBuffer BACKGROUND;\n"
+		"uniform usamplerBuffer SPRITES;\n"
+		"out vec2 tileCoord;\n"
+		"flat out int palette;\n"
+		//corners of the two triangles of a quad:
+		"const ivec2 Corners[6] = ivec2[6](ivec2(0,0), ivec2(0,8), ivec2(8,0), ivec2(0,8), ivec2(8,0), ivec2(8,8));\n"
+		"void main() {\n"
+		"	int quad = gl_VertexID / 6;\n"
+		"	ivec2 corner = Corners[gl_VertexID % 6];\n"
+		"	ivec2 lower_left;\n"
+		"	uint tile;\n"
+		"	if (LAYER == 0) {\n"
+		//background quads go through the four quarters of the background (32x30 tiles each) row by row:
+		"		int chunk = quad / (32 * 30);\n"
+		"		ivec2 at = ivec2(quad % 32, (quad / 32) % 30);\n"
+		"		ivec2 offset = ivec2(chunk % 2, chunk / 2) * ivec2(32, 30);\n"
+		"		uint info = texelFetch(BACKGROUND, (at.x + offset.x) + 64 * (at.y + offset.y)).r;\n"
+		"		lower_left = CHUNK_POSITIONS[chunk] + 8 * at;\n"
+		"		tile = info & 0xffu;\n"
+		"		palette = int((info >> 8) & 0x7u);\n"
+		"	} else {\n"
+		"		uvec4 sprite = texelFetch(SPRITES, quad);\n"
+		"		lower_left = ivec2(sprite.xy);\n"
+		"		tile = sprite.z;\n"
+		"		palette = int(sprite.w & 0x7u);\n"
+		//sprites of the other priority are collapsed to a point, so they don't cover any pixel:
+		"		if ((sprite.w & 0x80u) != (LAYER == 1 ? 0x80u : 0u)) corner = ivec2(0);\n"
+		"	}\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(lower_left + corner, 0.0, 1.0);\n"
+		"	tileCoord = vec2(ivec2(tile % 16u, tile / 16u) * 8 + corner);\n"
+		"}\n"
+	,
+		TileFragmentShader
+	);
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	CHUNK_POSITIONS_ivec2_4 = glGetUniformLocation(program, "CHUNK_POSITIONS");
+	LAYER_int = glGetUniformLocation(program, "LAYER");
+
+	GLuint TILE_TABLE_usampler2D = glGetUniformLocation(program, "TILE_TABLE");
+	GLuint PALETTE_TABLE_sampler2D = glGetUniformLocation(program, "PALETTE_TABLE");
+	GLuint BACKGROUND_usamplerBuffer = glGetUniformLocation(program, "BACKGROUND");
+	GLuint SPRITES_usamplerBuffer = glGetUniformLocation(program, "SPRITES");
+
+	//bind texture units indices to samplers:
+	glUseProgram(program);
+	glUniform1i(TILE_TABLE_usampler2D, 0);
+	glUniform1i(PALETTE_TABLE_sampler2D, 1);
+	glUniform1i(BACKGROUND_usamplerBuffer, 2);
+	glUniform1i(SPRITES_usamplerBuffer, 3);
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
+
+PPUPullProgram::~PPUPullProgram() {
+	if (program != 0) {
+		glDeleteProgram(program);
+		program = 0;
+	}
+}
+
+PPUTilemapProgram::PPUTilemapProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"out vec2 screenCoord;\n"
+		"void main() {\n"
+		//corners (0,0), (2*ScreenWidth,0), (0,2*ScreenHeight) -- a triangle whose inside contains the whole screen:
+		"	vec2 position = vec2((gl_VertexID & 1) * " + std::to_string(2 * PPU466::ScreenWidth) + ", (gl_VertexID >> 1) * " + std::to_string(2 * PPU466::ScreenHeight) + ");\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(position, 0.0, 1.0);\n"
+		"	screenCoord = position;\n"
+		"}\n"
 	,
 		//fragment shader:
 		"#version 330\n"
 		"uniform usampler2D TILE_TABLE;\n"
 		"uniform sampler2D PALETTE_TABLE;\n"
-		"in vec2 tileCoord;\n"
-		"flat in int palette;\n" //"flat" means "uses the value of the provoking [by default, last] vertex in the primitive"
+		"uniform usampler2D BACKGROUND;\n"
+		"uniform ivec2 BACKGROUND_POSITION;\n"
+		"in vec2 screenCoord;\n"
 		"out vec4 fragColor;\n"
 		"void main() {\n"
-		"	uint index = texelFetch(TILE_TABLE, ivec2(tileCoord), 0).r;\n"
+		"	ivec2 size = textureSize(BACKGROUND, 0) * 8;\n"
+		//pixel of the background under this fragment (BACKGROUND_POSITION is already in [0,size), so this is never negative):
+		"	ivec2 at = (ivec2(floor(screenCoord)) - BACKGROUND_POSITION + size) % size;\n"
+		"	uint info = texelFetch(BACKGROUND, at / 8, 0).r;\n"
+		"	uint tile = info & 0xffu;\n"
+		"	int palette = int((info >> 8) & 0x7u);\n"
+		"	uint index = texelFetch(TILE_TABLE, ivec2(tile % 16u, tile / 16u) * 8 + at % 8, 0).r;\n"
 		"	fragColor = texelFetch(PALETTE_TABLE, ivec2(index, palette), 0);\n"
-		//"	fragColor = vec4(float(index)/4.0,float(palette)/8,1,1);\n"
-		//"	fragColor = texelFetch(TILE_TABLE, ivec2(int(gl_FragCoord.x) % textureSize(TILE_TABLE,0).x, int(gl_FragCoord.y) % textureSize(TILE_TABLE,0).y), 0);\n"
-		//"	fragColor = texelFetch(PALETTE_TABLE, ivec2(int(gl_FragCoord.x) % textureSize(PALETTE_TABLE,0).x, int(gl_FragCoord.y) % textureSize(PALETTE_TABLE,0).y), 0);\n"
 		"}\n"
 	);
 
-	//look up the locations of vertex attributes:
-	Position_vec2 = glGetAttribLocation(program, "Position");
-	TileCoord_ivec2 = glGetAttribLocation(program, "TileCoord");
-	Palette_int = glGetAttribLocation(program, "Palette");
-
 	//look up the locations of uniforms:
 	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	BACKGROUND_POSITION_ivec2 = glGetUniformLocation(program, "BACKGROUND_POSITION");
 
 	GLuint TILE_TABLE_usampler2D = glGetUniformLocation(program, "TILE_TABLE");
 	GLuint PALETTE_TABLE_sampler2D = glGetUniformLocation(program, "PALETTE_TABLE");
+	GLuint BACKGROUND_usampler2D = glGetUniformLocation(program, "BACKGROUND");
 
 	//bind texture units indices to samplers:
 	glUseProgram(program);
 	glUniform1i(TILE_TABLE_usampler2D, 0);
 	glUniform1i(PALETTE_TABLE_sampler2D, 1);
+	glUniform1i(BACKGROUND_usampler2D, 4);
 	glUseProgram(0);
 
 	GL_ERRORS();
 }
 
-PPUTileProgram::~PPUTileProgram() {
+PPUTilemapProgram::~PPUTilemapProgram() {
 	if (program != 0) {
 		glDeleteProgram(program);
 		program = 0;
@@ -429,6 +850,35 @@ PPUDataStream::PPUDataStream() {
 	glBindTexture(GL_TEXTURE_2D, 0);
 
 
+	//buffer textures read their texels straight from a buffer, which is (re-)filled every frame by draw():
+	glGenBuffers(1, &background_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, background_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(PPU466::background), nullptr, GL_STREAM_DRAW);
+	glGenBuffers(1, &sprites_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, sprites_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(PPU466::sprites), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenTextures(1, &background_tex);
+	glBindTexture(GL_TEXTURE_BUFFER, background_tex);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, background_buffer);
+	glGenTextures(1, &sprites_tex);
+	glBindTexture(GL_TEXTURE_BUFFER, sprites_tex);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA8UI, sprites_buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	glGenTextures(1, &background_map_tex);
+	glBindTexture(GL_TEXTURE_2D, background_map_tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, PPU466::BackgroundWidth, PPU466::BackgroundHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenVertexArrays(1, &empty_vertex_array);
+
+
 	GL_ERRORS();
 }
 
@@ -449,4 +899,28 @@ PPUDataStream::~PPUDataStream() {
 		glDeleteTextures(1, &palette_tex);
 		palette_tex = 0;
 	}
+	if (background_tex != 0) {
+		glDeleteTextures(1, &background_tex);
+		background_tex = 0;
+	}
+	if (background_buffer != 0) {
+		glDeleteBuffers(1, &background_buffer);
+		background_buffer = 0;
+	}
+	if (sprites_tex != 0) {
+		glDeleteTextures(1, &sprites_tex);
+		sprites_tex = 0;
+	}
+	if (sprites_buffer != 0) {
+		glDeleteBuffers(1, &sprites_buffer);
+		sprites_buffer = 0;
+	}
+	if (background_map_tex != 0) {
+		glDeleteTextures(1, &background_map_tex);
+		background_map_tex = 0;
+	}
+	if (empty_vertex_array != 0) {
+		glDeleteVertexArrays(1, &empty_vertex_array);
+		empty_vertex_array = 0;
+	}
 }
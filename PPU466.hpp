@@ -7,6 +7,7 @@
 
 #include <glm/glm.hpp>
 #include <array>
+#include <vector>
 
 struct PPU466 {
 	PPU466();
@@ -18,6 +19,38 @@ struct PPU466 {
 	// pass the size of the current framebuffer in pixels so it knows how to scale itself
 	void draw(glm::uvec2 const &drawable_size) const;
 
+	//how draw() gets the tiles on the screen (all renderers draw the same image):
+	enum class Renderer : uint8_t {
+		//build a triangle strip with a quad per tile on the CPU and upload it every frame
+		TriangleStrip,
+		//upload the background and sprites arrays as they are (about 8 KB per frame)
+		// and build the quads in the vertex shader from the vertex index
+		VertexPulling,
+		//draw the sprites as VertexPulling does, but draw the background as a single screen-covering
+		// triangle that looks up the tile, palette, and texel of each pixel in a 64x60 background texture
+		Tilemap,
+	} renderer = Renderer::Tilemap;
+
+	//the renderers themselves, called by draw() once the tile and palette tables are uploaded:
+	void draw_triangle_strip() const;
+	void draw_vertex_pulling() const; //(also used for Tilemap)
+
+	//draw on the CPU instead (no OpenGL needed, e.g. for tests or when running without a window):
+	// fills 'pixels' with the ScreenWidth x ScreenHeight image draw() would show at 1x scale,
+	// as RGBA pixels in rows from the bottom up (the same layout glReadPixels uses)
+	// the screen is drawn in bands of rows on up to 'threads' threads (0 = one per hardware thread)
+	void draw_software(std::vector< glm::u8vec4 > *pixels, uint32_t threads = 0) const;
+
+	//draw the current state with each renderer into an offscreen ScreenWidth x ScreenHeight framebuffer
+	// and compare it with draw_software (needs an OpenGL context; used by main.cpp's --check-renderers):
+	// prints how many pixels of each renderer differ, and returns true if none do
+	bool check_renderers();
+
+	//when running without an OpenGL context (main.cpp's --headless), set 'headless' so draw() doesn't use OpenGL:
+	// draw() then draws with draw_software() into *headless_frame, or draws nothing if headless_frame is null
+	static bool headless;
+	static std::vector< glm::u8vec4 > *headless_frame;
+
 	//--------------------------------------------------------------
 	//Set the values below to control the PPU's drawing:
 
@@ -0,0 +1,304 @@
+#include "PPU466.hpp"
+
+//PPU466::draw_software -- draws on the CPU what PPU466::draw draws with OpenGL.
+// Kept out of PPU466.cpp so that it doesn't need OpenGL (or a window) at all.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PPU_SSE2
+#endif
+
+//-------------------------------------------------------------------
+//Worker threads that draw bands of rows.
+//Threads are started once and kept waiting, since starting threads every frame would cost more than drawing the frame:
+
+struct BandWorkers {
+	BandWorkers() {
+		uint32_t count = std::max(1U, std::thread::hardware_concurrency()) - 1;
+		for (uint32_t i = 0; i < count; ++i) {
+			threads.emplace_back([this](){ work(); });
+		}
+	}
+	~BandWorkers() {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		for (auto &thread : threads) {
+			thread.join();
+		}
+	}
+
+	//calls job(band) for every band in [0,bands) on the workers and the calling thread; returns once all bands are done:
+	void run(uint32_t bands, std::function< void(uint32_t) > const &job_) {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			job = &job_;
+			band_count = bands;
+			next_band = 0;
+			//every thread checks in when it runs out of bands, so no thread is still looking at this job when run() returns:
+			working = uint32_t(threads.size());
+			++generation;
+		}
+		wake.notify_all();
+
+		draw_bands();
+
+		std::unique_lock< std::mutex > lock(mutex);
+		done.wait(lock, [this](){ return working == 0; });
+		job = nullptr;
+	}
+
+	std::vector< std::thread > threads;
+
+	std::mutex mutex;
+	std::condition_variable wake; //signalled when a job is posted (or on quit)
+	std::condition_variable done; //signalled when a worker has run out of bands
+	bool quit = false;
+	uint64_t generation = 0; //incremented for every job
+	uint32_t working = 0; //workers that haven't yet run out of bands in the current job
+
+	std::function< void(uint32_t) > const *job = nullptr;
+	uint32_t band_count = 0;
+	std::atomic< uint32_t > next_band{0};
+
+private:
+	//take the next band not yet claimed, until there are none left:
+	void draw_bands() {
+		for (uint32_t band = next_band++; band < band_count; band = next_band++) {
+			(*job)(band);
+		}
+	}
+
+	void work() {
+		uint64_t seen = 0;
+		while (true) {
+			{
+				std::unique_lock< std::mutex > lock(mutex);
+				wake.wait(lock, [&](){ return quit || generation != seen; });
+				if (quit) return;
+				seen = generation;
+			}
+			draw_bands();
+			{
+				std::unique_lock< std::mutex > lock(mutex);
+				working -= 1;
+			}
+			done.notify_one();
+		}
+	}
+};
+
+//-------------------------------------------------------------------
+//Blending, as glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) does it on an 8-bit framebuffer:
+// every channel (including alpha) becomes src * src_alpha / 255 + dst * (255 - src_alpha) / 255
+//OpenGL leaves the rounding of those products up to the implementation;
+// this rounds them the way Mesa's software rasterizer (llvmpipe) does, so images match it exactly.
+// (Every implementation agrees when alpha is 0 or 255.)
+
+//x * y / 255 for x, y in [0,255]:
+static inline uint32_t mul255(uint32_t x, uint32_t y) {
+	uint32_t z = x * y;
+	return (z + 128 + (z >> 8)) >> 8;
+}
+
+//colors are RGBA bytes in memory order, handled as uint32_t:
+static inline uint32_t blend(uint32_t src, uint32_t dst) {
+	uint32_t a = src >> 24;
+	uint32_t ret = 0;
+	for (uint32_t shift = 0; shift < 32; shift += 8) {
+		ret |= (mul255((src >> shift) & 0xff, a) + mul255((dst >> shift) & 0xff, 255 - a)) << shift;
+	}
+	return ret;
+}
+
+#if defined(PPU_SSE2)
+//blend four pixels at once:
+static inline __m128i blend4(__m128i src, __m128i dst) {
+	__m128i const zero = _mm_setzero_si128();
+	__m128i const x255 = _mm_set1_epi16(255);
+	__m128i const x128 = _mm_set1_epi16(128);
+
+	//mul255 on 16-bit lanes (the largest intermediate is 255 * 255 + 128 + 254, so nothing overflows):
+	auto mul = [&](__m128i x, __m128i y) {
+		__m128i z = _mm_mullo_epi16(x, y);
+		return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(z, x128), _mm_srli_epi16(z, 8)), 8);
+	};
+
+	//widen to 16 bits per channel (two pixels per register):
+	auto half = [&](__m128i s, __m128i d) {
+		//alpha of each pixel in all four of its channels:
+		__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+		return _mm_add_epi16(mul(s, a), mul(d, _mm_sub_epi16(x255, a)));
+	};
+	__m128i lo = half(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero));
+	__m128i hi = half(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero));
+	return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+//blend 'count' (at most 8) pixels of a tile row -- given as color indices -- over 'dst' using a four-color palette:
+static inline void blend_row(uint32_t *dst, uint8_t const *indices, uint32_t count, uint32_t const *palette) {
+#if defined(PPU_SSE2)
+	if (count == 8) {
+		//palette lookup by comparing every index against each of the four possible values:
+		__m128i const zero = _mm_setzero_si128();
+		__m128i wide = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast< __m128i const * >(indices)), zero);
+		auto lookup = [&](__m128i index) {
+			__m128i color = _mm_and_si128(_mm_cmpeq_epi32(index, zero), _mm_set1_epi32(int32_t(palette[0])));
+			color = _mm_or_si128(color, _mm_and_si128(_mm_cmpeq_epi32(index, _mm_set1_epi32(1)), _mm_set1_epi32(int32_t(palette[1]))));
+			color = _mm_or_si128(color, _mm_and_si128(_mm_cmpeq_epi32(index, _mm_set1_epi32(2)), _mm_set1_epi32(int32_t(palette[2]))));
+			color = _mm_or_si128(color, _mm_and_si128(_mm_cmpeq_epi32(index, _mm_set1_epi32(3)), _mm_set1_epi32(int32_t(palette[3]))));
+			return color;
+		};
+		__m128i *out = reinterpret_cast< __m128i * >(dst);
+		_mm_storeu_si128(out + 0, blend4(lookup(_mm_unpacklo_epi16(wide, zero)), _mm_loadu_si128(out + 0)));
+		_mm_storeu_si128(out + 1, blend4(lookup(_mm_unpackhi_epi16(wide, zero)), _mm_loadu_si128(out + 1)));
+		return;
+	}
+#endif
+	for (uint32_t i = 0; i < count; ++i) {
+		dst[i] = blend(palette[indices[i]], dst[i]);
+	}
+}
+
+//-------------------------------------------------------------------
+
+void PPU466::draw_software(std::vector< glm::u8vec4 > *pixels_, uint32_t threads) const {
+	assert(pixels_);
+	auto &pixels = *pixels_;
+	pixels.resize(ScreenWidth * ScreenHeight);
+
+	//expand the tile table to one color index per byte (tile i, row y, column x is at 64 * i + 8 * y + x):
+	std::array< uint8_t, 16 * 16 * 64 > tile_indices;
+	for (uint32_t i = 0; i < tile_table.size(); ++i) {
+		Tile const &tile = tile_table[i];
+		uint8_t *out = tile_indices.data() + 64 * i;
+#if defined(PPU_SSE2)
+		//spread each bit plane row across eight bytes (two rows per register), then test one bit per byte:
+		__m128i const bits = _mm_set_epi8(-128,64,32,16,8,4,2,1, -128,64,32,16,8,4,2,1);
+		auto spread = [](uint8_t const *rows, __m128i quads[4]) {
+			__m128i pairs = _mm_loadl_epi64(reinterpret_cast< __m128i const * >(rows));
+			pairs = _mm_unpacklo_epi8(pairs, pairs);
+			__m128i lo = _mm_unpacklo_epi16(pairs, pairs);
+			__m128i hi = _mm_unpackhi_epi16(pairs, pairs);
+			quads[0] = _mm_unpacklo_epi32(lo, lo);
+			quads[1] = _mm_unpackhi_epi32(lo, lo);
+			quads[2] = _mm_unpacklo_epi32(hi, hi);
+			quads[3] = _mm_unpackhi_epi32(hi, hi);
+		};
+		__m128i bit0[4], bit1[4];
+		spread(tile.bit0.data(), bit0);
+		spread(tile.bit1.data(), bit1);
+		for (uint32_t r = 0; r < 4; ++r) {
+			__m128i index = _mm_or_si128(
+				_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(bit0[r], bits), bits), _mm_set1_epi8(1)),
+				_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(bit1[r], bits), bits), _mm_set1_epi8(2))
+			);
+			_mm_storeu_si128(reinterpret_cast< __m128i * >(out + 16 * r), index);
+		}
+#else
+		for (uint32_t y = 0; y < 8; ++y) {
+			for (uint32_t x = 0; x < 8; ++x) {
+				out[8 * y + x] = uint8_t(
+					  ((tile.bit0[y] >> x) & 1)
+					| ((tile.bit1[y] >> x) & 1) << 1
+				);
+			}
+		}
+#endif
+	}
+
+	//palettes as packed colors:
+	static_assert(sizeof(Palette) == 4 * sizeof(uint32_t), "palette is packed");
+	std::array< std::array< uint32_t, 4 >, 8 > palettes;
+	std::memcpy(palettes.data(), palette_table.data(), sizeof(palettes));
+
+	uint32_t clear_color;
+	{
+		glm::u8vec4 color = glm::u8vec4(background_color.r, background_color.g, background_color.b, 0xff);
+		std::memcpy(&clear_color, &color, sizeof(clear_color));
+	}
+
+	//background_position, reduced to [0,BackgroundWidth*8)x[0,BackgroundHeight*8):
+	constexpr int32_t BackgroundWidthPixels = int32_t(BackgroundWidth) * 8;
+	constexpr int32_t BackgroundHeightPixels = int32_t(BackgroundHeight) * 8;
+	int32_t const position_x = ((background_position.x % BackgroundWidthPixels) + BackgroundWidthPixels) % BackgroundWidthPixels;
+	int32_t const position_y = ((background_position.y % BackgroundHeightPixels) + BackgroundHeightPixels) % BackgroundHeightPixels;
+
+	//draw one row of the screen, in the same order as draw(): 'behind' sprites, background, 'in front' sprites:
+	auto draw_row = [&](uint32_t y, uint32_t *row) {
+		std::fill(row, row + ScreenWidth, clear_color);
+
+		auto draw_sprites = [&](uint8_t priority) {
+			for (auto const &sprite : sprites) {
+				if ((sprite.attributes & 0x80) != priority) continue;
+				if (y < sprite.y || y >= uint32_t(sprite.y) + 8) continue;
+				blend_row(
+					row + sprite.x,
+					tile_indices.data() + 64 * sprite.index + 8 * (y - sprite.y),
+					std::min(8U, ScreenWidth - sprite.x), //sprites are clipped at the right edge of the screen
+					palettes[sprite.attributes & 0x07].data()
+				);
+			}
+		};
+
+		draw_sprites(0x80);
+
+		{ //background, starting from the (possibly partial) tile under the left edge of the screen:
+			uint32_t by = uint32_t(int32_t(y) - position_y + BackgroundHeightPixels) % BackgroundHeightPixels;
+			uint16_t const *background_row = background.data() + BackgroundWidth * (by / 8);
+			uint32_t bx = uint32_t(BackgroundWidthPixels - position_x) % BackgroundWidthPixels;
+			for (uint32_t x = 0; x < ScreenWidth; ) {
+				uint32_t offset = bx % 8;
+				uint32_t count = std::min(8 - offset, ScreenWidth - x);
+				uint16_t info = background_row[bx / 8];
+				blend_row(
+					row + x,
+					tile_indices.data() + 64 * (info & 0xff) + 8 * (by % 8) + offset,
+					count,
+					palettes[(info >> 8) & 0x07].data()
+				);
+				x += count;
+				bx = (bx + count) % BackgroundWidthPixels;
+			}
+		}
+
+		draw_sprites(0x00);
+	};
+
+	//split the screen into bands of rows:
+	static_assert(sizeof(glm::u8vec4) == sizeof(uint32_t), "pixels are packed");
+	uint32_t *out = reinterpret_cast< uint32_t * >(pixels.data());
+	if (threads == 0) threads = std::max(1U, std::thread::hardware_concurrency());
+	uint32_t bands = std::min(threads, uint32_t(ScreenHeight) / 8);
+
+	auto draw_band = [&](uint32_t band) {
+		uint32_t begin = ScreenHeight * band / bands;
+		uint32_t end = ScreenHeight * (band + 1) / bands;
+		for (uint32_t y = begin; y < end; ++y) {
+			draw_row(y, out + ScreenWidth * y);
+		}
+	};
+
+	if (bands == 1) {
+		draw_band(0);
+	} else {
+		static BandWorkers workers;
+		//only one frame at a time can use the workers:
+		static std::mutex workers_mutex;
+		std::unique_lock< std::mutex > lock(workers_mutex);
+		workers.run(bands, draw_band);
+	}
+}
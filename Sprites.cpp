@@ -1,38 +1,167 @@
 #include "Sprites.hpp"
 
-#include <filesystem>
-#include <fstream>
-#include <vector>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
 
 #include "read_write_chunk.hpp"
-#include "PPU466.hpp"
+#include "parsing/sprite_ids.hpp"
 
-
-Sprite Sprite::load(std::string const &filename)
+Sprites Sprites::load(std::string const &filename)
 {
+    Sprites ret;
+    ret.archive = MappedFile(filename);
 
-    std::ifstream file(filename, std::ios::binary);
+    // The chunks are read in place, in the order they were written
+    std::span<Entry const> entries;
+    std::vector<Entry> swapped_entries;
+    std::span<Sprite::TileRef const> tile_refs;
+    std::span<char const> names;
+    std::span<MapEntry const> map_entries;
+    std::vector<MapEntry> swapped_map_entries;
+    std::span<uint16_t const> map_tiles;
+    try
+    {
+        std::span<uint8_t const> data(ret.archive.data(), ret.archive.size());
+        read_chunk_file_header(data);
+        read_chunk_v2(data, "tile", &ret.tile_table);
+        read_chunk_v2(data, "palt", &ret.palette_table);
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            read_chunk_v2(data, "sprt", &entries);
+            read_chunk_v2(data, "refs", &tile_refs);
+            read_chunk_v2(data, "name", &names);
+            read_chunk_v2(data, "maps", &map_entries);
+            read_chunk_v2(data, "bgnd", &map_tiles);
+        }
+        else
+        {
+            // The archive is little-endian, so the multi-byte fields are swapped into copies on other hosts
+            read_chunk_v2(data, "sprt", &swapped_entries);
+            read_chunk_v2(data, "refs", &ret.swapped_tile_refs);
+            read_chunk_v2(data, "name", &names);
+            read_chunk_v2(data, "maps", &swapped_map_entries);
+            read_chunk_v2(data, "bgnd", &ret.swapped_map_tiles);
+            entries = swapped_entries;
+            tile_refs = ret.swapped_tile_refs;
+            map_entries = swapped_map_entries;
+            map_tiles = ret.swapped_map_tiles;
+        }
+    }
+    catch (std::exception const &e)
+    {
+        throw std::runtime_error("'" + filename + "' is not a valid asset archive: " + e.what());
+    }
 
-    Sprite sprite;
+    ret.index_sprites("The tables of '" + filename + "'", entries, tile_refs, names);
+    ret.index_maps("The tables of '" + filename + "'", map_entries, map_tiles, names);
+    return ret;
+}
 
-    read_chunk(file, "refs", &sprite.tiles);
+Sprites Sprites::embedded()
+{
+    Sprites ret;
+    ret.tile_table = EmbeddedAssets::tile_table;
+    ret.palette_table = EmbeddedAssets::palette_table;
+    ret.index_sprites("The embedded tables", EmbeddedAssets::entries, EmbeddedAssets::tile_refs, EmbeddedAssets::names);
+    ret.index_maps("The embedded tables", EmbeddedAssets::map_entries, EmbeddedAssets::map_tiles, EmbeddedAssets::names);
+    return ret;
+}
 
-    sprite.name = std::filesystem::path(filename).stem();
+void Sprites::index_sprites(std::string const &source, std::span<Entry const> entries, std::span<Sprite::TileRef const> tile_refs, std::span<char const> names)
+{
+    // Build views over the tile refs and names (a single allocation, whatever the number of sprites)
+    sprites.clear();
+    sprites.reserve(entries.size());
+    for (Entry const &entry : entries)
+    {
+        if (entry.name_offset > names.size() || entry.name_length > names.size() - entry.name_offset ||
+            entry.first_tile_ref > tile_refs.size() || entry.tile_ref_count > tile_refs.size() - entry.first_tile_ref)
+        {
+            throw std::runtime_error(source + " have a sprite pointing outside of the tables");
+        }
+        Sprite sprite;
+        sprite.name = std::string_view(names.data() + entry.name_offset, entry.name_length);
+        sprite.tiles = tile_refs.subspan(entry.first_tile_ref, entry.tile_ref_count);
+        if (!sprites.empty() && !(sprites.back().name < sprite.name))
+        {
+            throw std::runtime_error(source + " have sprites that are not sorted by name");
+        }
+        sprites.push_back(sprite);
+    }
 
-    return sprite;
+    // The game refers to sprites by the IDs generated along with the archive, so they have to match
+    bool matches = sprites.size() == SpriteCount;
+    for (size_t i = 0; matches && i < SpriteCount; i++)
+    {
+        matches = sprites[i].name == SpriteNames[i];
+    }
+    if (!matches)
+    {
+        throw std::runtime_error(source + " don't hold the sprites of parsing/sprite_ids.hpp, rebuild the game after running parsing/parse_ppm");
+    }
 }
 
-Sprites Sprites::load(std::string const &filename)
+void Sprites::index_maps(std::string const &source, std::span<MapEntry const> entries, std::span<uint16_t const> map_tiles, std::span<char const> names)
 {
-    Sprites ret;
-    // Load all the sprites in a directory
-    for (const auto &entry : std::filesystem::recursive_directory_iterator(filename))
+    maps.clear();
+    maps.reserve(entries.size());
+    for (MapEntry const &entry : entries)
     {
-        ret.sprites.emplace(entry.path().stem(), Sprite::load(entry.path()));
+        size_t size = size_t(entry.width) * entry.height;
+        if (entry.name_offset > names.size() || entry.name_length > names.size() - entry.name_offset ||
+            entry.first_entry > map_tiles.size() || size > map_tiles.size() - entry.first_entry)
+        {
+            throw std::runtime_error(source + " have a map pointing outside of the tables");
+        }
+        Map map;
+        map.name = std::string_view(names.data() + entry.name_offset, entry.name_length);
+        map.width = entry.width;
+        map.height = entry.height;
+        map.tiles = map_tiles.subspan(entry.first_entry, size);
+        maps.push_back(map);
+    }
+
+    bool matches = maps.size() == MapCount;
+    for (size_t i = 0; matches && i < MapCount; i++)
+    {
+        matches = maps[i].name == MapNames[i];
+    }
+    if (!matches)
+    {
+        throw std::runtime_error(source + " don't hold the maps of parsing/sprite_ids.hpp, rebuild the game after running parsing/parse_ppm");
     }
-    return ret;
 }
 
-Sprite const &Sprites::lookup(std::string const &name) {
-    return sprites.at(name);
-}
\ No newline at end of file
+void Map::copy_to(std::array<uint16_t, PPU466::BackgroundWidth * PPU466::BackgroundHeight> &background, uint32_t x, uint32_t y) const
+{
+    if (width == 0 || height == 0)
+    {
+        return;
+    }
+    for (uint32_t row = 0; row < PPU466::BackgroundHeight; row++)
+    {
+        uint16_t const *source = tiles.data() + size_t((y + row) % height) * width;
+        uint16_t *destination = background.data() + size_t(row) * PPU466::BackgroundWidth;
+        // Each row is copied in as few runs as possible, wrapping around the right edge of the map
+        for (uint32_t column = 0; column < PPU466::BackgroundWidth;)
+        {
+            uint32_t from = (x + column) % width;
+            uint32_t run = std::min<uint32_t>(width - from, PPU466::BackgroundWidth - column);
+            std::memcpy(destination + column, source + from, run * sizeof(uint16_t));
+            column += run;
+        }
+    }
+}
+
+Sprite const &Sprites::lookup(std::string_view name) const
+{
+    auto found = std::lower_bound(sprites.begin(), sprites.end(), name, [](Sprite const &sprite, std::string_view name)
+                                  { return sprite.name < name; });
+    if (found == sprites.end() || found->name != name)
+    {
+        throw std::runtime_error("No sprite named '" + std::string(name) + "' in the asset archive");
+    }
+    return *found;
+}
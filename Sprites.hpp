@@ -1,10 +1,19 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <stdint.h>
-#include <map>
+#include <span>
+#include <array>
 #include <vector>
 
+#include "PPU466.hpp"
+#include "mapped_file.hpp"
+
+// Generated by parsing/parse_ppm in parsing/sprite_ids.hpp
+enum class SpriteID : uint16_t;
+enum class MapID : uint16_t;
+
 struct Sprite
 {
 
@@ -18,22 +27,149 @@ struct Sprite
     };
     static_assert(sizeof(TileRef) == 8, "TileRef doesn't contain padding bytes.");
 
-    std::vector<TileRef> tiles;
+    // Tile refs of the sprite, pointing into the asset archive it was loaded from
+    std::span<TileRef const> tiles;
 
-    std::string name;
+    std::string_view name;
+};
+
+// A background map, drawn with the same tile and palette tables as the sprites
+struct Map
+{
+    std::string_view name;
 
-    // Load sprite from the given filepath
-    static Sprite load(std::string const &filename);
+    // Size of the map in tiles (maps larger than the PPU background hold several screens)
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    // Entries of the map row by row from its bottom left tile, in the layout of PPU466::background
+    // (bits 0-7: tile index, bits 8-10: palette index), pointing into the asset archive it was loaded from
+    std::span<uint16_t const> tiles;
+
+    // Copies the part of the map whose bottom left tile is (x, y) to a PPU background, row by row.
+    // The map wraps around, so a single-screen map fills the whole background from any position.
+    void copy_to(std::array<uint16_t, PPU466::BackgroundWidth * PPU466::BackgroundHeight> &background, uint32_t x = 0, uint32_t y = 0) const;
 };
 
+// All the sprites of the game, along with the tile and palette tables they index into.
+// Everything is read from a single asset archive written by parsing/parse_ppm: a chunk file
+// (see read_chunk_file_header in read_write_chunk.hpp) made of these chunks:
+//  "tile": the tile table
+//  "palt": the palette table
+//  "sprt": one Entry per sprite, sorted by name
+//  "refs": the tile refs of all the sprites, one sprite after the other
+//  "name": the names of all the sprites, one after the other, followed by the names of the maps
+//  "maps": one MapEntry per background map, sorted by name
+//  "bgnd": the entries of all the maps, one map after the other
+// Every chunk is checksummed and its payload is 16-byte aligned in the file,
+// so the archive is checked then used in place once mapped.
 struct Sprites
 {
+    // Table of contents entry of a sprite in the archive
+    struct Entry
+    {
+        // Position of the name in the "name" chunk
+        uint32_t name_offset = 0;
+        uint32_t name_length = 0;
+        // Position of the first tile ref in the "refs" chunk
+        uint32_t first_tile_ref = 0;
+        uint32_t tile_ref_count = 0;
+    };
+    static_assert(sizeof(Entry) == 16, "Entry doesn't contain padding bytes.");
+
+    // Table of contents entry of a background map in the archive
+    struct MapEntry
+    {
+        // Position of the name in the "name" chunk
+        uint32_t name_offset = 0;
+        uint32_t name_length = 0;
+        // Position of the first entry in the "bgnd" chunk
+        uint32_t first_entry = 0;
+        // Size of the map in tiles
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+    static_assert(sizeof(MapEntry) == 20, "MapEntry doesn't contain padding bytes.");
+
     // Look up a specific sprite by name  and
     // return a reference to it (or throw an error if failure)
-    Sprite const &lookup(std::string const &name);
+    Sprite const &lookup(std::string_view name) const;
+
+    // Get a sprite by its generated ID (no lookup needed)
+    Sprite const &operator[](SpriteID id) const { return sprites[size_t(id)]; }
 
-    // Load sprites from the given filepath
+    // Get a map by its generated ID
+    Map const &operator[](MapID id) const { return maps[size_t(id)]; }
+
+    // Map the asset archive at the given filepath (throws if it is malformed
+    // or doesn't hold the sprites and maps listed in parsing/sprite_ids.hpp)
     static Sprites load(std::string const &filename);
 
-    std::map<std::string, Sprite> sprites;
+    // Use the assets compiled into the game from parsing/embedded_assets.cpp (no file is read)
+    static Sprites embedded();
+
+    // Builds the sprites from a table of contents ('source' names the tables in errors)
+    void index_sprites(std::string const &source, std::span<Entry const> entries, std::span<Sprite::TileRef const> tile_refs, std::span<char const> names);
+
+    // Builds the maps from their table of contents ('source' names the tables in errors)
+    void index_maps(std::string const &source, std::span<MapEntry const> entries, std::span<uint16_t const> map_tiles, std::span<char const> names);
+
+    std::span<PPU466::Tile const> tile_table;
+    std::span<PPU466::Palette const> palette_table;
+
+    // Sorted by name, so a sprite's index is its SpriteID
+    std::vector<Sprite> sprites;
+
+    // Sorted by name, so a map's index is its MapID
+    std::vector<Map> maps;
+
+    // Keeps the archive mapped, since all the tables and sprites point into it
+    MappedFile archive;
+
+    // Tile refs and map entries swapped to host order, only used on big-endian hosts
+    std::vector<Sprite::TileRef> swapped_tile_refs;
+    std::vector<uint16_t> swapped_map_tiles;
+};
+
+// Width of the integers in each table of the archive, so it can be byte-swapped on big-endian hosts
+// (see read_write_chunk.hpp). Numbers need no entry, and structures must not mix integer widths.
+template <typename T>
+struct ChunkWordSize;
+template <>
+struct ChunkWordSize<PPU466::Tile>
+{
+    static constexpr size_t value = 1;
+};
+template <>
+struct ChunkWordSize<PPU466::Palette>
+{
+    static constexpr size_t value = 1;
+};
+template <>
+struct ChunkWordSize<Sprites::Entry>
+{
+    static constexpr size_t value = 4;
+};
+template <>
+struct ChunkWordSize<Sprites::MapEntry>
+{
+    static constexpr size_t value = 4;
+};
+template <>
+struct ChunkWordSize<Sprite::TileRef>
+{
+    static constexpr size_t value = 2;
+};
+
+// The same tables as parsing/assets.ppu, compiled into the game.
+// Defined in parsing/embedded_assets.cpp, which is generated by parsing/parse_ppm.
+struct EmbeddedAssets
+{
+    static std::span<PPU466::Tile const> const tile_table;
+    static std::span<PPU466::Palette const> const palette_table;
+    static std::span<Sprites::Entry const> const entries;
+    static std::span<Sprite::TileRef const> const tile_refs;
+    static std::span<char const> const names;
+    static std::span<Sprites::MapEntry const> const map_entries;
+    static std::span<uint16_t const> const map_tiles;
 };
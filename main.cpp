@@ -25,6 +25,96 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Running without a window or OpenGL context (e.g., for soak tests, benchmarks, and automated playthroughs on machines without a display):
+struct HeadlessOptions {
+	bool headless = false; //--headless
+	uint64_t frames = 0; //--frames N : stop after N frames (0, the default, runs until the mode quits)
+	float fps = 60.0f; //--fps N : every update advances time by 1/N seconds
+	bool realtime = false; //--realtime : wait between frames to run at 'fps' frames per second (instead of as fast as possible)
+	bool draw = false; //--draw : draw every frame on the CPU (instead of not drawing at all)
+	std::string screenshot; //--screenshot FILE : save the last frame (drawn on the CPU) to FILE as a PNG
+	std::string compare; //--compare FILE : compare the last frame (drawn on the CPU) with the PNG image FILE, failing if any pixel differs
+};
+
+static int run_headless(HeadlessOptions const &options, bool hot_reload) {
+	//there is no OpenGL context, so only load what doesn't need one:
+	call_load_functions(false);
+
+	//the PPU draws on the CPU, and only if the frame is wanted:
+	PPU466::headless = true;
+	std::vector< glm::u8vec4 > frame;
+
+	Mode::set_current(std::make_shared< GameMode >(hot_reload));
+
+	//updates always advance time by the same step, so runs don't depend on how fast the machine is:
+	float elapsed = 1.0f / options.fps;
+	auto step = std::chrono::duration_cast< std::chrono::high_resolution_clock::duration >(std::chrono::duration< float >(elapsed));
+
+	auto start_time = std::chrono::high_resolution_clock::now();
+	auto next_time = start_time;
+	uint64_t frames = 0;
+	while (Mode::current && (options.frames == 0 || frames < options.frames)) {
+		//draw the frame if it is wanted (when there is no frame limit, the screenshot is of whichever frame turns out to be the last):
+		bool last = (options.frames != 0 && frames + 1 == options.frames);
+		bool want_last = !options.screenshot.empty() || !options.compare.empty();
+		bool want_frame = options.draw || (want_last && (options.frames == 0 || last));
+		PPU466::headless_frame = (want_frame ? &frame : nullptr);
+
+		//there are no events without a window, so just update and draw:
+		Mode::current->update(elapsed);
+		if (!Mode::current) break;
+		Mode::current->draw(glm::uvec2(PPU466::ScreenWidth, PPU466::ScreenHeight));
+		++frames;
+
+		if (options.realtime) {
+			next_time += step;
+			std::this_thread::sleep_until(next_time);
+		}
+	}
+	PPU466::headless_frame = nullptr;
+
+	float seconds = std::chrono::duration< float >(std::chrono::high_resolution_clock::now() - start_time).count();
+	std::cout << "Ran " << frames << " frames (" << frames * elapsed << "s of game time) in " << seconds << "s: " << frames / std::max(seconds, 1e-6f) << " frames per second." << std::endl;
+
+	if (!options.screenshot.empty()) {
+		if (frame.empty()) {
+			std::cerr << "No frame was drawn, so no screenshot was saved." << std::endl;
+			return 1;
+		}
+		std::cout << "Saving screenshot to '" << options.screenshot << "'." << std::endl;
+		for (auto &px : frame) {
+			px.a = 0xff;
+		}
+		save_png(options.screenshot, glm::uvec2(PPU466::ScreenWidth, PPU466::ScreenHeight), frame.data(), LowerLeftOrigin);
+	}
+
+	if (!options.compare.empty()) {
+		if (frame.empty()) {
+			std::cerr << "No frame was drawn, so nothing was compared." << std::endl;
+			return 1;
+		}
+		glm::uvec2 size;
+		std::vector< glm::u8vec4 > expected;
+		load_png(options.compare, &size, &expected, LowerLeftOrigin);
+		if (size != glm::uvec2(PPU466::ScreenWidth, PPU466::ScreenHeight)) {
+			std::cerr << "'" << options.compare << "' is " << size.x << "x" << size.y << ", not the size of the screen." << std::endl;
+			return 1;
+		}
+		//(screenshots are saved opaque, so only the colors are compared)
+		uint32_t differing = 0;
+		for (uint32_t i = 0; i < frame.size(); ++i) {
+			if (frame[i].r != expected[i].r || frame[i].g != expected[i].g || frame[i].b != expected[i].b) ++differing;
+		}
+		std::cout << differing << " pixels of the last frame differ from '" << options.compare << "'." << std::endl;
+		if (differing != 0) return 1;
+	}
+
+	return 0;
+}
 
 #ifdef _WIN32
 extern "C" { uint32_t GetACP(); }
@@ -45,6 +135,80 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	HeadlessOptions options;
+	bool hot_reload = false; //--hot-reload : reload parsing/assets.ppu when it changes (for development, see GameMode::check_assets)
+	bool check_renderers = false; //--check-renderers : draw the first frame with every renderer, compare them with the CPU renderer, and quit
+	{
+		bool headless_only = false; //was an option that only applies to --headless given?
+		bool bad = false;
+		for (int i = 1; i < argc && !bad; ++i) {
+			std::string arg = argv[i];
+			//for the options that take a value:
+			std::string value = (i + 1 < argc ? argv[i + 1] : "");
+			try {
+				if (arg == "--headless") {
+					options.headless = true;
+				} else if (arg == "--hot-reload") {
+					hot_reload = true;
+				} else if (arg == "--seed" && !value.empty()) {
+					//(parsed as signed, so a negative seed is rejected instead of wrapping around)
+					size_t end = 0;
+					long long seed = std::stoll(value, &end);
+					bad = !(end == value.size() && seed > 0 && seed <= 0xffffffffLL);
+					GameMode::seed = uint32_t(seed);
+					++i;
+				} else if (arg == "--check-renderers") {
+					check_renderers = true;
+				} else if (arg == "--frames" && !value.empty()) {
+					//(parsed as signed, so a negative count is rejected instead of wrapping around)
+					size_t end = 0;
+					long long frames = std::stoll(value, &end);
+					bad = !(end == value.size() && frames > 0);
+					options.frames = uint64_t(frames);
+					headless_only = true;
+					++i;
+				} else if (arg == "--fps" && !value.empty()) {
+					size_t end = 0;
+					options.fps = std::stof(value, &end);
+					bad = !(end == value.size() && options.fps > 0.0f);
+					headless_only = true;
+					++i;
+				} else if (arg == "--realtime") {
+					options.realtime = true;
+					headless_only = true;
+				} else if (arg == "--draw") {
+					options.draw = true;
+					headless_only = true;
+				} else if (arg == "--screenshot" && !value.empty()) {
+					options.screenshot = value;
+					headless_only = true;
+					++i;
+				} else if (arg == "--compare" && !value.empty()) {
+					options.compare = value;
+					headless_only = true;
+					++i;
+				} else if (arg.rfind("--", 0) == 0) {
+					bad = true;
+				} else {
+					//other arguments are left alone, since some launchers add their own (e.g., -psn_... on macOS)
+				}
+			} catch (std::exception const &) {
+				//(a value that isn't a number)
+				bad = true;
+			}
+		}
+		if (bad || (headless_only && !options.headless) || (check_renderers && options.headless)) {
+			std::cerr << "Usage: " << argv[0] << " [--hot-reload] [--seed N] [--check-renderers | --headless [--frames N] [--fps N] [--realtime] [--draw] [--screenshot FILE] [--compare FILE]]" << std::endl;
+			return 1;
+		}
+	}
+
+	if (options.headless) {
+		return run_headless(options, hot_reload);
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
@@ -108,7 +272,19 @@ int main(int argc, char **argv) {
 	call_load_functions();
 
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< GameMode >());
+	Mode::set_current(std::make_shared< GameMode >(hot_reload));
+
+	if (check_renderers) {
+		//set up the first frame as the main loop would, then draw it every way:
+		std::shared_ptr< GameMode > game = std::dynamic_pointer_cast< GameMode >(Mode::current);
+		game->update(0.0f);
+		game->draw(glm::uvec2(PPU466::ScreenWidth, PPU466::ScreenHeight));
+		bool same = game->ppu.check_renderers();
+		SDL_GL_DestroyContext(context);
+		SDL_DestroyWindow(Mode::window);
+		Mode::window = NULL;
+		return same ? 0 : 1;
+	}
 
 	//------------ main loop ------------
 
@@ -0,0 +1,96 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile(std::string const &filename) {
+	#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open '" + filename + "' for mapping.");
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size)) {
+		CloseHandle(file);
+		throw std::runtime_error("Failed to get the size of '" + filename + "'.");
+	}
+	size_ = size_t(file_size.QuadPart);
+	if (size_ != 0) {
+		mapping_ = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping_) {
+			data_ = reinterpret_cast< uint8_t const * >(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+		}
+		if (!data_) {
+			if (mapping_) CloseHandle(mapping_);
+			mapping_ = nullptr;
+			CloseHandle(file);
+			throw std::runtime_error("Failed to map '" + filename + "'.");
+		}
+	}
+	//the mapping keeps its own reference to the file:
+	CloseHandle(file);
+	#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open '" + filename + "' for mapping.");
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw std::runtime_error("Failed to get the size of '" + filename + "'.");
+	}
+	size_ = size_t(info.st_size);
+	//mapping an empty file fails, so empty files just have no data:
+	if (size_ != 0) {
+		void *mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			close(fd);
+			throw std::runtime_error("Failed to map '" + filename + "'.");
+		}
+		data_ = reinterpret_cast< uint8_t const * >(mapped);
+	}
+	//the mapping stays valid after the descriptor is closed:
+	close(fd);
+	#endif
+}
+
+MappedFile::~MappedFile() {
+	unmap();
+}
+
+MappedFile::MappedFile(MappedFile &&other) {
+	*this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) {
+	if (this != &other) {
+		unmap();
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		#if defined(_WIN32)
+		std::swap(mapping_, other.mapping_);
+		#endif
+	}
+	return *this;
+}
+
+void MappedFile::unmap() {
+	#if defined(_WIN32)
+	if (data_) UnmapViewOfFile(data_);
+	if (mapping_) CloseHandle(mapping_);
+	mapping_ = nullptr;
+	#else
+	if (data_) munmap(const_cast< uint8_t * >(data_), size_);
+	#endif
+	data_ = nullptr;
+	size_ = 0;
+}
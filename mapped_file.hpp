@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Read-only memory mapping of a whole file.
+ * The contents stay valid for as long as the MappedFile is alive.
+ */
+
+struct MappedFile {
+	MappedFile() = default;
+	//NOTE: throws if the file can't be opened or mapped
+	explicit MappedFile(std::string const &filename);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+	MappedFile(MappedFile &&other);
+	MappedFile &operator=(MappedFile &&other);
+
+	uint8_t const *data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	void unmap();
+
+	uint8_t const *data_ = nullptr;
+	size_t size_ = 0;
+	#if defined(_WIN32)
+	void *mapping_ = nullptr; //HANDLE of the file mapping object
+	#endif
+};
@@ -3,9 +3,23 @@
 #include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cctype>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <charconv>
+#include <iterator>
 
 #include "data_path.hpp"
 #include "read_write_chunk.hpp"
+#include "load_save_png.hpp"
 
 #include <bitset>
 #define ANSI_COLOR_RED "\x1b[31m"
@@ -16,311 +30,2220 @@
 #define ANSI_COLOR_CYAN "\x1b[36m"
 #define ANSI_COLOR_RESET "\x1b[0m"
 
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
+// For getpid
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PPM_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PPM_NEON
+#endif
+
 // Define the indexes in a colour
 constexpr int RED = 0;
 constexpr int GREEN = 1;
 constexpr int BLUE = 2;
 constexpr int ALPHA = 3;
 
-void PPM_Parser::parse_chunk(std::string const &filename)
+// Reads the whitespace separated numbers of a PPM file straight from its mapped bytes,
+// skipping '#' comments and keeping track of lines so errors can point at the faulty token
+struct PPM_Reader
+{
+    PPM_Reader(std::string const &filename_, uint8_t const *begin, uint8_t const *end_)
+        : filename(filename_), at(reinterpret_cast<char const *>(begin)), end(reinterpret_cast<char const *>(end_)), line_start(at)
+    {
+    }
+
+    std::string const &filename;
+    char const *at;
+    char const *end;
+    // Start of the current line and its number (from 1), for error messages
+    char const *line_start;
+    uint32_t line = 1;
+
+    // Moves to the start of the next token
+    void skip_whitespace()
+    {
+        // Tokens are nearly always separated by a single space
+        if (at < end && *at == ' ')
+        {
+            at++;
+        }
+        while (at < end && is_separator(*at))
+        {
+            if (*at == '\n')
+            {
+                line++;
+                line_start = at + 1;
+            }
+            else if (*at == '#')
+            {
+                at = std::find(at, end, '\n') - 1;
+            }
+            at++;
+        }
+    }
+
+    // Reads the next number, which must not be greater than max ('what' names it in errors)
+    uint32_t read_value(char const *what, uint32_t max)
+    {
+        skip_whitespace();
+        uint32_t value = 0;
+        std::from_chars_result result = std::from_chars(at, end, value);
+        if (result.ec != std::errc() || value > max || (result.ptr < end && !is_separator(*result.ptr)))
+        {
+            invalid_value(what, max, result);
+        }
+        at = result.ptr;
+        return value;
+    }
+
+    // Reads count colour values, none greater than max, into out.
+    // The common case of values separated by single spaces is handled on local copies of the position,
+    // which the compiler can keep in registers while writing the values.
+    void read_colours(uint8_t *out, size_t count, uint32_t max)
+    {
+        char const *position = at;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (position < end && *position == ' ')
+            {
+                position++;
+            }
+            uint32_t value = 0;
+            std::from_chars_result result = std::from_chars(position, end, value);
+            if (result.ec != std::errc() || value > max || (result.ptr < end && !is_separator(*result.ptr)))
+            {
+                // Comments, line breaks and errors go through the general path
+                at = position;
+                value = read_value("colour value", max);
+                result.ptr = at;
+            }
+            out[i] = uint8_t(value);
+            position = result.ptr;
+        }
+        at = position;
+    }
+
+    [[noreturn]] void invalid_value(char const *what, uint32_t max, std::from_chars_result result) const
+    {
+        if (at == end)
+        {
+            fail("unexpected end of file, expected the " + std::string(what));
+        }
+        if (result.ec == std::errc() && (result.ptr == end || is_separator(*result.ptr)))
+        {
+            fail("the " + std::string(what) + " " + std::string(at, result.ptr) + " is greater than " + std::to_string(max));
+        }
+        if (result.ec == std::errc::result_out_of_range)
+        {
+            fail("the " + std::string(what) + " " + token() + " is too large");
+        }
+        fail("expected the " + std::string(what) + ", found '" + token() + "'");
+    }
+
+    // Checks that the file starts with the given magic number followed by a separator
+    bool read_magic(char const *magic)
+    {
+        size_t length = std::strlen(magic);
+        if (size_t(end - at) < length || std::memcmp(at, magic, length) != 0 || (at + length < end && !is_separator(at[length])))
+        {
+            return false;
+        }
+        at += length;
+        return true;
+    }
+
+    // Whitespace or the start of a comment
+    static bool is_separator(char c)
+    {
+        return c == ' ' || c == '\n' || c == '#' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // The token starting at the current position (for error messages)
+    std::string token() const
+    {
+        char const *token_end = at;
+        while (token_end < end && token_end - at < 16 && !is_separator(*token_end))
+        {
+            token_end++;
+        }
+        return std::string(at, token_end);
+    }
+
+    [[noreturn]] void fail(std::string const &message) const
+    {
+        throw std::runtime_error("'" + filename + "' line " + std::to_string(line) + ", column " + std::to_string(at - line_start + 1) + ": " + message);
+    }
+};
+
+PPM_Image PPM_Image::load(std::string const &filename)
+{
+    PPM_Image image;
+    image.mapping = MappedFile(filename);
+
+    uint8_t const *begin = image.mapping.data();
+    uint8_t const *end = begin + image.mapping.size();
+
+    static uint8_t const PNGSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    if (image.mapping.size() >= sizeof(PNGSignature) && std::memcmp(begin, PNGSignature, sizeof(PNGSignature)) == 0)
+    {
+        image.mapping = MappedFile();
+
+        glm::uvec2 size;
+        load_png(filename, &size, &image.png_storage, UpperLeftOrigin);
+        image.width = size.x;
+        image.height = size.y;
+        image.channels = 4;
+        image.pixels = reinterpret_cast<uint8_t const *>(image.png_storage.data());
+        image.row_stride = size_t(image.width) * 4;
+        return image;
+    }
+
+    PPM_Reader reader(filename, begin, end);
+    bool binary = reader.read_magic("P6");
+    if (!binary && !reader.read_magic("P3"))
+    {
+        throw std::runtime_error("'" + filename + "' is not a PPM P3 or P6 image or a PNG image");
+    }
+    image.width = reader.read_value("width", 0xffff);
+    image.height = reader.read_value("height", 0xffff);
+    uint32_t colours = reader.read_value("maximum colour value", 255);
+    image.row_stride = size_t(image.width) * 3;
+
+    if (binary)
+    {
+        // A single whitespace character separates the header from the pixels
+        uint8_t const *at = reinterpret_cast<uint8_t const *>(reader.at) + 1;
+        if (at > end || size_t(end - at) < image.row_stride * image.height)
+        {
+            throw std::runtime_error("'" + filename + "' is missing pixel data");
+        }
+        image.pixels = at;
+        return image;
+    }
+
+    // ASCII images are decoded once into memory, then the mapping is no longer needed
+    image.storage.resize(image.row_stride * image.height);
+    reader.read_colours(image.storage.data(), image.storage.size(), colours);
+    image.mapping = MappedFile();
+    image.pixels = image.storage.data();
+
+    return image;
+}
+
+size_t TileHash::operator()(PPU466::Tile const &tile) const
+{
+    // Both bit planes fit in two 64 bit words, which are mixed together
+    uint64_t bit0, bit1;
+    std::memcpy(&bit0, tile.bit0.data(), sizeof(bit0));
+    std::memcpy(&bit1, tile.bit1.data(), sizeof(bit1));
+    uint64_t hash = bit0 * 0x9e3779b97f4a7c15ull ^ bit1;
+    hash ^= hash >> 31;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 29;
+    return size_t(hash);
+}
+
+bool TileEqual::operator()(PPU466::Tile const &a, PPU466::Tile const &b) const
+{
+    return a.bit0 == b.bit0 && a.bit1 == b.bit1;
+}
+
+void PPM_Parser::parse_chunk(ChunkView const &chunk)
+{
+    tile_refs.push_back(register_chunk(gather_chunk(chunk)));
+}
+
+// Packs an RGBA colour in 32 bits
+static uint32_t pack_colour(glm::u8vec4 const &colour)
+{
+    return uint32_t(colour[RED]) | uint32_t(colour[GREEN]) << 8 | uint32_t(colour[BLUE]) << 16 | uint32_t(colour[ALPHA]) << 24;
+}
+
+static glm::u8vec4 unpack_colour(uint32_t colour)
+{
+    return glm::u8vec4(colour & 0xff, (colour >> 8) & 0xff, (colour >> 16) & 0xff, colour >> 24);
+}
+
+// Colour of a pixel as stored in a palette.
+// For RGB pixels magenta is transparent and everything else is opaque, RGBA pixels keep their alpha.
+// Fully transparent pixels all become transparent magenta so they share a single palette slot.
+static glm::u8vec4 pixel_colour(uint8_t const *pixel, uint8_t channels)
+{
+    bool transparent;
+    if (channels == 4)
+    {
+        transparent = pixel[ALPHA] == 0;
+    }
+    else
+    {
+        transparent = pixel[RED] == 0xff && pixel[GREEN] == 0 && pixel[BLUE] == 0xff;
+    }
+    if (transparent)
+    {
+        return glm::u8vec4(0xff, 0, 0xff, 0);
+    }
+    return glm::u8vec4(pixel[RED], pixel[GREEN], pixel[BLUE], channels == 4 ? pixel[ALPHA] : 0xff);
+}
+
+// Sorts the first count packed colours (insertion sort, there are at most four)
+static void sort_colours(std::array<uint32_t, 4> &colours, uint8_t count)
+{
+    for (uint8_t i = 1; i < count; i++)
+    {
+        for (uint8_t j = i; j > 0 && colours[j - 1] > colours[j]; j--)
+        {
+            std::swap(colours[j - 1], colours[j]);
+        }
+    }
+}
+
+// Builds the set made of the colours selected by the bits of mask (colours must be sorted)
+static ColourSet colour_subset(uint32_t const *colours, uint8_t count, uint32_t mask)
+{
+    ColourSet set;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (mask & (1 << i))
+        {
+            set.colours[set.count++] = colours[i];
+        }
+    }
+    return set;
+}
+
+size_t ColourSetHash::operator()(ColourSet const &set) const
+{
+    uint64_t hash = set.count;
+    for (uint32_t colour : set.colours)
+    {
+        hash = (hash ^ colour) * 0x100000001b3ull;
+        hash ^= hash >> 32;
+    }
+    return size_t(hash);
+}
+
+LocalChunk PPM_Parser::gather_chunk_scalar(ChunkView const &chunk) const
+{
+    LocalChunk local;
+    PPU466::Palette &palette = local.palette;
+    local.tile = {0};
+
+    // Free slots are transparent red, which can't come from a pixel
+    // (the only fully transparent colour pixel_colour returns is magenta)
+    for (glm::u8vec4 &colour : palette)
+    {
+        colour = glm::u8vec4(0xff, 0, 0, 0);
+    }
+
+    size_t colours_registered = 0;
+    size_t colour_index = 0;
+    // Distinct colours that found no room in the palette
+    std::array<glm::u8vec4, 64> lost;
+    size_t colours_lost = 0;
+    // The chunk is read from top to bottom but tiles are stored from bottom to top
+    for (uint32_t pixel_count = 0; pixel_count < uint32_t(chunk_size * chunk_size); pixel_count++)
+    {
+        uint32_t x = pixel_count % chunk_size;
+        uint32_t y = pixel_count / chunk_size;
+        glm::u8vec4 colour = pixel_colour(chunk.at(x, y), chunk.channels);
+
+        // Check if the current colour has already been registered in the palette
+        bool to_register = true;
+        for (size_t i = 0; i < colours_registered; i++)
+        {
+            if (colour == palette[i])
+            {
+                colour_index = i;
+                to_register = false;
+                break;
+            }
+        }
+
+        // If there is still space in the palette and a new colour has been found, add it in the palette.
+        // Colours that don't fit in the palette reuse the colour of the previous pixel.
+        if (to_register && colours_registered < palette.size())
+        {
+            palette[colours_registered] = colour;
+            colour_index = colours_registered;
+            colours_registered++;
+        }
+        else if (to_register && std::find(lost.begin(), lost.begin() + colours_lost, colour) == lost.begin() + colours_lost)
+        {
+            lost[colours_lost++] = colour;
+        }
+
+        // Add the pixel to the tile
+        uint32_t row = chunk_size - 1 - y;
+        local.tile.bit0[row] += (colour_index % 2) << x;
+        local.tile.bit1[row] += ((colour_index >> 1) % 2) << x;
+    }
+
+    local.colours_registered = uint8_t(colours_registered);
+    local.colours_lost = uint8_t(colours_lost);
+    return local;
+}
+
+// Returns a mask where bit i is set if colours[i] == colour, for 64 colours
+static uint64_t match_colours(uint32_t const *colours, uint32_t colour)
+{
+    uint64_t mask = 0;
+#if defined(PPM_SSE2)
+    __m128i value = _mm_set1_epi32(int(colour));
+    for (uint32_t i = 0; i < 64; i += 16)
+    {
+        __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(colours + i)), value);
+        __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(colours + i + 4)), value);
+        __m128i c = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(colours + i + 8)), value);
+        __m128i d = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(colours + i + 12)), value);
+        // Narrow the 32 bit lane results to bytes so one movemask covers 16 colours
+        __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        mask |= uint64_t(uint16_t(_mm_movemask_epi8(bytes))) << i;
+    }
+#elif defined(PPM_NEON)
+    uint32x4_t value = vdupq_n_u32(colour);
+    // Weight of each lane once the comparisons are narrowed to bytes
+    static uint8_t const Weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t weights = vld1q_u8(Weights);
+    for (uint32_t i = 0; i < 64; i += 16)
+    {
+        uint16x8_t ab = vcombine_u16(vmovn_u32(vceqq_u32(vld1q_u32(colours + i), value)), vmovn_u32(vceqq_u32(vld1q_u32(colours + i + 4), value)));
+        uint16x8_t cd = vcombine_u16(vmovn_u32(vceqq_u32(vld1q_u32(colours + i + 8), value)), vmovn_u32(vceqq_u32(vld1q_u32(colours + i + 12), value)));
+        uint8x16_t bytes = vandq_u8(vcombine_u8(vmovn_u16(ab), vmovn_u16(cd)), weights);
+        mask |= uint64_t(vaddv_u8(vget_low_u8(bytes)) | vaddv_u8(vget_high_u8(bytes)) << 8) << i;
+    }
+#else
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        mask |= uint64_t(colours[i] == colour) << i;
+    }
+#endif
+    return mask;
+}
+
+LocalChunk PPM_Parser::gather_chunk(ChunkView const &chunk) const
+{
+    if (!vectorised || chunk_size != 8)
+    {
+        return gather_chunk_scalar(chunk);
+    }
+
+    // Colour of every pixel, packed in 32 bits, from the top left
+    alignas(16) uint32_t colours[64];
+    for (uint32_t y = 0; y < 8; y++)
+    {
+        for (uint32_t x = 0; x < 8; x++)
+        {
+            colours[y * 8 + x] = pack_colour(pixel_colour(chunk.at(x, y), chunk.channels));
+        }
+    }
+
+    // The first pixel not covered by the colours found so far brings the next colour,
+    // which gives the same colour order as reading the pixels one by one
+    uint64_t masks[4] = {0, 0, 0, 0};
+    uint32_t firsts[4] = {0, 0, 0, 0};
+    uint64_t covered = 0;
+    uint8_t colours_registered = 0;
+    uint32_t first = 0;
+    while (covered != ~uint64_t(0))
+    {
+        if (colours_registered == 4)
+        {
+            // More than four colours: the extra colours depend on the pixels before them
+            return gather_chunk_scalar(chunk);
+        }
+        while (covered >> first & 1)
+        {
+            first++;
+        }
+        firsts[colours_registered] = first;
+        masks[colours_registered] = match_colours(colours, colours[first]);
+        covered |= masks[colours_registered];
+        colours_registered++;
+    }
+
+    LocalChunk local;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        // Free slots are transparent red, as in gather_chunk_scalar
+        local.palette[i] = i < colours_registered ? unpack_colour(colours[firsts[i]]) : glm::u8vec4(0xff, 0, 0, 0);
+    }
+
+    // Bit 0 of the colour index is set for colours 1 and 3, bit 1 for colours 2 and 3.
+    // Byte y of each plane holds row y from the top, and tiles are stored from the bottom.
+    uint64_t bit0 = masks[1] | masks[3];
+    uint64_t bit1 = masks[2] | masks[3];
+    for (uint32_t y = 0; y < 8; y++)
+    {
+        local.tile.bit0[7 - y] = uint8_t(bit0 >> (8 * y));
+        local.tile.bit1[7 - y] = uint8_t(bit1 >> (8 * y));
+    }
+
+    local.colours_registered = colours_registered;
+    return local;
+}
+
+void PPM_Parser::index_palette(uint16_t palette_index)
+{
+    PPU466::Palette const &palette = palette_table[palette_index];
+    uint8_t count = palette_sizes[palette_index];
+
+    std::array<uint32_t, 4> colours;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        colours[i] = pack_colour(palette[i]);
+    }
+    sort_colours(colours, count);
+
+    // Earlier palettes keep priority for the subsets they share with this one
+    for (uint32_t mask = 1; mask < (1u << count); mask++)
+    {
+        std::vector<uint16_t> &palettes = palette_subsets[colour_subset(colours.data(), count, mask)];
+        if (std::find(palettes.begin(), palettes.end(), palette_index) == palettes.end())
+        {
+            palettes.push_back(palette_index);
+        }
+    }
+}
+
+// Colours of a chunk in canonical order
+static ColourSet chunk_colours(LocalChunk const &chunk)
+{
+    ColourSet set;
+    set.count = chunk.colours_registered;
+    for (uint8_t i = 0; i < set.count; i++)
+    {
+        set.colours[i] = pack_colour(chunk.palette[i]);
+    }
+    sort_colours(set.colours, set.count);
+    return set;
+}
+
+// Union of two colour sets, or false if it holds more than four colours
+static bool colour_union(ColourSet const &a, ColourSet const &b, ColourSet *result)
+{
+    ColourSet merged = a;
+    for (uint8_t i = 0; i < b.count; i++)
+    {
+        if (std::find(a.colours.begin(), a.colours.begin() + a.count, b.colours[i]) != a.colours.begin() + a.count)
+        {
+            continue;
+        }
+        if (merged.count == merged.colours.size())
+        {
+            return false;
+        }
+        merged.colours[merged.count++] = b.colours[i];
+    }
+    sort_colours(merged.colours, merged.count);
+    *result = merged;
+    return true;
+}
+
+void PPM_Parser::pack_palettes(std::vector<SlicedImage> const &images)
+{
+    // Every distinct set of colours used by a chunk, with the images using it
+    std::unordered_map<ColourSet, std::vector<size_t>, ColourSetHash> users;
+    for (size_t image = 0; image < images.size(); image++)
+    {
+        for (LocalChunk const &chunk : images[image].chunks)
+        {
+            std::vector<size_t> &set_users = users[chunk_colours(chunk)];
+            if (set_users.empty() || set_users.back() != image)
+            {
+                set_users.push_back(image);
+            }
+        }
+    }
+
+    // Place the largest sets first (first fit decreasing), in a fixed order so the packing is deterministic
+    std::vector<ColourSet> sets;
+    for (auto const &entry : users)
+    {
+        sets.push_back(entry.first);
+    }
+    std::sort(sets.begin(), sets.end(), [](ColourSet const &a, ColourSet const &b)
+              { return a.count != b.count ? a.count > b.count : a.colours < b.colours; });
+
+    // Each set goes in the palette it shares the most colours with, as long as the union still fits in a palette
+    std::vector<ColourSet> palettes;
+    std::vector<std::vector<ColourSet>> packed;
+    for (ColourSet const &set : sets)
+    {
+        size_t best = palettes.size();
+        int best_shared = -1;
+        ColourSet best_union;
+        for (size_t i = 0; i < palettes.size(); i++)
+        {
+            ColourSet merged;
+            if (!colour_union(palettes[i], set, &merged))
+            {
+                continue;
+            }
+            int shared = palettes[i].count + set.count - merged.count;
+            if (shared > best_shared)
+            {
+                best = i;
+                best_shared = shared;
+                best_union = merged;
+            }
+        }
+        if (best == palettes.size())
+        {
+            palettes.push_back(set);
+            packed.emplace_back();
+        }
+        else
+        {
+            palettes[best] = best_union;
+        }
+        packed[best].push_back(set);
+    }
+
+    // Merge palettes whose colours fit together until no more merges are possible
+    for (bool merged_any = true; merged_any;)
+    {
+        merged_any = false;
+        for (size_t i = 0; i < palettes.size(); i++)
+        {
+            for (size_t j = i + 1; j < palettes.size(); j++)
+            {
+                ColourSet merged;
+                if (colour_union(palettes[i], palettes[j], &merged))
+                {
+                    palettes[i] = merged;
+                    packed[i].insert(packed[i].end(), packed[j].begin(), packed[j].end());
+                    palettes.erase(palettes.begin() + j);
+                    packed.erase(packed.begin() + j);
+                    merged_any = true;
+                    j--;
+                }
+            }
+        }
+    }
+
+    // The most used palettes come first, so they are the ones kept within the budget
+    std::vector<size_t> usage(palettes.size(), 0);
+    std::vector<size_t> order(palettes.size());
+    for (size_t i = 0; i < palettes.size(); i++)
+    {
+        order[i] = i;
+        for (ColourSet const &set : packed[i])
+        {
+            usage[i] += users[set].size();
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&usage](size_t a, size_t b)
+                     { return usage[a] > usage[b]; });
+
+    if (palettes.size() > palette_budget)
+    {
+        std::string message = "The sprites need " + std::to_string(palettes.size()) + " palettes but only " + std::to_string(palette_budget) + " are available. Sprites using the palettes that don't fit:";
+        std::vector<size_t> offending;
+        for (size_t i = palette_budget; i < order.size(); i++)
+        {
+            for (ColourSet const &set : packed[order[i]])
+            {
+                offending.insert(offending.end(), users[set].begin(), users[set].end());
+            }
+        }
+        // Atlas sprites share the file of their manifest, so each line names the sprite, then where it comes from
+        std::vector<std::string> lines;
+        for (size_t image : offending)
+        {
+            lines.push_back(images[image].name + " (" + images[image].filename + ")");
+        }
+        std::sort(lines.begin(), lines.end());
+        lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+        for (std::string const &line : lines)
+        {
+            message += "\n    " + line;
+        }
+        throw std::runtime_error(message);
+    }
+
+    for (size_t i : order)
+    {
+        PPU466::Palette palette;
+        for (uint8_t slot = 0; slot < palette.size(); slot++)
+        {
+            // Free slots are transparent red, as in gather_chunk
+            palette[slot] = slot < palettes[i].count ? unpack_colour(palettes[i].colours[slot]) : glm::u8vec4(0xff, 0, 0, 0);
+        }
+        palette_table.push_back(palette);
+        palette_sizes.push_back(palettes[i].count);
+        index_palette(uint16_t(palette_table.size() - 1));
+    }
+}
+
+uint16_t PPM_Parser::register_palette(LocalChunk const &chunk)
+{
+    ColourSet chunk_set = chunk_colours(chunk);
+    uint8_t count = chunk_set.count;
+    std::array<uint32_t, 4> &colours = chunk_set.colours;
+
+    // Look for a palette that already contains all the colours of the chunk
+    uint32_t all = (1u << count) - 1;
+    auto found = palette_subsets.find(colour_subset(colours.data(), count, all));
+    if (found != palette_subsets.end())
+    {
+        return found->second.front();
+    }
+
+    // Otherwise, look for a palette sharing as many colours as possible with the chunk
+    // and with enough free slots to hold the colours it is missing
+    for (int shared = int(count) - 1; shared > 0; shared--)
+    {
+        for (uint32_t mask = 1; mask < all; mask++)
+        {
+            if (int(std::bitset<4>(mask).count()) != shared)
+            {
+                continue;
+            }
+            found = palette_subsets.find(colour_subset(colours.data(), count, mask));
+            if (found == palette_subsets.end())
+            {
+                continue;
+            }
+
+            // The first palette holding these colours may be full, so every palette holding them is tried
+            for (uint16_t palette_index : found->second)
+            {
+                PPU466::Palette &palette = palette_table[palette_index];
+                uint8_t &size = palette_sizes[palette_index];
+
+                // Colours of the chunk the palette doesn't have yet
+                std::array<uint32_t, 4> missing;
+                uint8_t nb_missing = 0;
+                for (uint8_t i = 0; i < count; i++)
+                {
+                    bool present = false;
+                    for (uint8_t j = 0; j < size; j++)
+                    {
+                        present = present || pack_colour(palette[j]) == colours[i];
+                    }
+                    if (!present)
+                    {
+                        missing[nb_missing++] = colours[i];
+                    }
+                }
+                if (size + nb_missing > palette.size())
+                {
+                    continue;
+                }
+
+                // Colours already used by tiles keep their slot, new colours go in the free slots
+                for (uint8_t i = 0; i < nb_missing; i++)
+                {
+                    palette[size++] = unpack_colour(missing[i]);
+                }
+                index_palette(palette_index);
+                return palette_index;
+            }
+        }
+    }
+
+    palette_table.push_back(chunk.palette);
+    palette_sizes.push_back(count);
+    uint16_t palette_index = uint16_t(palette_table.size() - 1);
+    index_palette(palette_index);
+    return palette_index;
+}
+
+Sprite::TileRef PPM_Parser::register_chunk(LocalChunk const &chunk)
+{
+    uint16_t palette_index = register_palette(chunk);
+    PPU466::Palette const &palette = palette_table[palette_index];
+
+    // Slot of each of the chunk's colours in the registered palette
+    std::array<uint8_t, 4> slots = {0, 0, 0, 0};
+    for (uint8_t i = 0; i < chunk.colours_registered; i++)
+    {
+        for (uint8_t j = 0; j < palette_sizes[palette_index]; j++)
+        {
+            if (palette[j] == chunk.palette[i])
+            {
+                slots[i] = j;
+                break;
+            }
+        }
+    }
+
+    // Tile this image will be represented as: the local tile with its colour indices moved to their slots
+    PPU466::Tile tile = {0};
+    for (uint32_t row = 0; row < chunk_size; row++)
+    {
+        for (uint32_t x = 0; x < chunk_size; x++)
+        {
+            uint8_t colour_index = slots[((chunk.tile.bit0[row] >> x) & 1) | ((chunk.tile.bit1[row] >> x) & 1) << 1];
+            tile.bit0[row] |= (colour_index & 1) << x;
+            tile.bit1[row] |= (colour_index >> 1) << x;
+        }
+    }
+
+    // Constructing the tile ref for our new tile
+    Sprite::TileRef tile_ref = {0};
+
+    tile_ref.palette_index = palette_index;
+    tile_ref.offset_x_chunk = chunk.offset_x_chunk;
+    tile_ref.offset_y_chunk = chunk.offset_y_chunk;
+
+    // Reuse the tile if an identical one has already been registered
+    auto found = tile_indices.find(tile);
+    if (found != tile_indices.end())
+    {
+        tile_ref.tile_index = found->second;
+    }
+    else
+    {
+        tile_ref.tile_index = tile_table.size();
+        tile_indices.emplace(tile, tile_ref.tile_index);
+        tile_table.push_back(tile);
+    }
+
+    return tile_ref;
+}
+
+std::vector<LocalChunk> PPM_Parser::slice_region(PPM_Image const &image, uint32_t left, uint32_t top, uint32_t width, uint32_t height) const
+{
+    if (left > image.width || width > image.width - left || top > image.height || height > image.height - top)
+    {
+        throw std::runtime_error("Region " + std::to_string(width) + "x" + std::to_string(height) + " at (" + std::to_string(left) + ", " + std::to_string(top) +
+                                 ") is outside of the " + std::to_string(image.width) + "x" + std::to_string(image.height) + " image");
+    }
+
+    // Number of chunks in the region
+    uint32_t chunks_in_row = (width + chunk_size - 1) / chunk_size;
+    uint32_t chunks_in_column = (height + chunk_size - 1) / chunk_size;
+
+    // Sprites are anchored at their bottom left, so when the size of the region isn't a multiple of the chunk size
+    // the chunks hang over its right and top edges: the top row of chunks starts this many rows above the region
+    uint32_t rows_above = chunks_in_column * chunk_size - height;
+
+    // Chunks hanging over the edges are copied here and padded with transparent pixels
+    std::vector<uint8_t> padded(size_t(chunk_size) * chunk_size * image.channels);
+    std::array<uint8_t, 4> transparent = {0xff, 0, 0xff, 0};
+
+    std::vector<LocalChunk> chunks;
+    chunks.reserve(size_t(chunks_in_row) * chunks_in_column);
+    for (uint32_t chunk_y = 0; chunk_y < chunks_in_column; chunk_y++)
+    {
+        for (uint32_t chunk_x = 0; chunk_x < chunks_in_row; chunk_x++)
+        {
+            uint32_t x_in_region = chunk_x * chunk_size;
+            // Row of the region at the top of the chunk, counting the padding rows above the region
+            uint32_t y_in_padded = chunk_y * chunk_size;
+
+            ChunkView view;
+            view.row_stride = image.row_stride;
+            view.channels = image.channels;
+
+            if (x_in_region + chunk_size > width || y_in_padded < rows_above)
+            {
+                for (uint32_t y = 0; y < chunk_size; y++)
+                {
+                    for (uint32_t x = 0; x < chunk_size; x++)
+                    {
+                        bool inside = x_in_region + x < width && y_in_padded + y >= rows_above;
+                        uint8_t const *from = inside ? image.pixels + (top + y_in_padded + y - rows_above) * image.row_stride + (left + x_in_region + x) * image.channels
+                                                     : transparent.data();
+                        std::memcpy(&padded[(y * chunk_size + x) * image.channels], from, image.channels);
+                    }
+                }
+                view.pixels = padded.data();
+                view.row_stride = size_t(chunk_size) * image.channels;
+            }
+            else
+            {
+                view.pixels = image.pixels + (top + y_in_padded - rows_above) * image.row_stride + (left + x_in_region) * image.channels;
+            }
+
+            LocalChunk chunk = gather_chunk(view);
+
+            chunk.offset_x_chunk = chunk_x;
+
+            // The image is read from top left to bottom right
+            // but the sprite is displayed from bottom left to top right
+            chunk.offset_y_chunk = chunks_in_column - 1 - chunk_y;
+
+            chunks.push_back(chunk);
+        }
+    }
+
+    return chunks;
+}
+
+// Names a standalone image after its file: <name>.ppm is a sprite and <name>.map.ppm a background map
+static void name_image(SlicedImage *sliced, std::string const &filename)
+{
+    std::filesystem::path stem = std::filesystem::path(filename).stem();
+    sliced->filename = filename;
+    sliced->map = stem.extension() == ".map";
+    sliced->name = (sliced->map ? stem.stem() : stem).string();
+}
+
+SlicedImage PPM_Parser::slice_image(std::string const &filename) const
+{
+    SlicedImage sliced;
+    name_image(&sliced, filename);
+    PPM_Image image = PPM_Image::load(filename);
+    sliced.chunks = slice_region(image, 0, 0, image.width, image.height);
+    return sliced;
+}
+
+AtlasManifest AtlasManifest::load(std::string const &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open atlas manifest '" + filename + "'");
+    }
+
+    AtlasManifest manifest;
+    manifest.filename = filename;
+
+    std::string line;
+    for (uint32_t line_number = 1; std::getline(file, line); line_number++)
+    {
+        auto fail = [&](std::string const &message)
+        {
+            throw std::runtime_error("'" + filename + "' line " + std::to_string(line_number) + ": " + message);
+        };
+
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string command;
+        if (!(words >> command))
+        {
+            continue;
+        }
+
+        if (command == "image")
+        {
+            std::string image;
+            if (!(words >> image))
+            {
+                fail("expected the path of the image");
+            }
+            manifest.image = (std::filesystem::path(filename).parent_path() / image).string();
+        }
+        else if (command == "sprite" || command == "strip")
+        {
+            Region region;
+            uint32_t frames = 1;
+            if (!(words >> region.name >> region.x >> region.y >> region.width >> region.height) || (command == "strip" && !(words >> frames)))
+            {
+                fail(command == "sprite" ? "expected 'sprite <name> <x> <y> <width> <height>'" : "expected 'strip <name> <x> <y> <frame width> <height> <frame count>'");
+            }
+            if (region.width == 0 || region.height == 0 || frames == 0)
+            {
+                fail("'" + region.name + "' is empty");
+            }
+            if (command == "sprite")
+            {
+                manifest.regions.push_back(region);
+            }
+            else
+            {
+                // The frames of a strip are side by side, named <name>_0, <name>_1, ...
+                std::string name = region.name;
+                for (uint32_t frame = 0; frame < frames; frame++)
+                {
+                    region.name = name + "_" + std::to_string(frame);
+                    manifest.regions.push_back(region);
+                    region.x += region.width;
+                }
+            }
+        }
+        else
+        {
+            fail("unknown command '" + command + "'");
+        }
+
+        std::string extra;
+        if (words >> extra)
+        {
+            fail("unexpected '" + extra + "'");
+        }
+    }
+
+    if (manifest.image.empty())
+    {
+        throw std::runtime_error("'" + filename + "' doesn't name its image (add a line 'image <path>')");
+    }
+    return manifest;
+}
+
+// Version of the cached chunk format and of the way chunks are gathered.
+// Bump it whenever either changes so stale cache entries are ignored.
+constexpr uint64_t CacheVersion = 3;
+
+// Hashes a block of memory (64 bits at a time, then the remaining bytes)
+static uint64_t hash_bytes(uint8_t const *data, size_t size, uint64_t hash)
+{
+    auto mix = [&hash](uint64_t word)
+    {
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 29;
+    };
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        mix(word);
+    }
+    uint64_t tail = 0;
+    // (data may be null when size is 0, and memcpy must not be given a null pointer)
+    if (size > i)
+    {
+        std::memcpy(&tail, data + i, size - i);
+    }
+    mix(tail ^ uint64_t(size) << 56);
+    mix(size);
+    return hash;
+}
+
+// Key of the cache entries: the version of the cache and every setting that changes how images are sliced
+static uint64_t cache_key_base(uint8_t chunk_size)
+{
+    return hash_bytes(nullptr, 0, CacheVersion ^ uint64_t(chunk_size) << 32);
+}
+
+bool PPM_Parser::load_cached(uint64_t key, std::vector<LocalChunk> *chunks, std::string *cache_entry) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ppu", (unsigned long long)key);
+    *cache_entry = name;
+    std::filesystem::path path = std::filesystem::path(cache_directory) / name;
+
+    std::error_code error;
+    if (std::filesystem::exists(path, error))
+    {
+        try
+        {
+            // Entries are compressed, so they go through the inflating read into a vector
+            // (the in-place read into a span refuses compressed chunks)
+            MappedFile cached(path.string());
+            std::span<uint8_t const> data(cached.data(), cached.size());
+            read_chunk(data, "chnk", chunks);
+            return true;
+        }
+        catch (std::exception const &e)
+        {
+            // A damaged entry is rebuilt, but said so: an entry that can never be read would otherwise
+            // silently turn every run into a full parse
+            std::cerr << ANSI_COLOR_YELLOW << "Rebuilding the cache entry '" << name << "': " << e.what() << ANSI_COLOR_RESET << std::endl;
+            chunks->clear();
+        }
+    }
+    return false;
+}
+
+// Name of a temporary file to write before renaming it to 'path', unique to this process and call
+// so that concurrent runs (e.g. --watch next to a manual run) never write the same temporary file
+static std::filesystem::path temporary_path(std::filesystem::path path)
+{
+    static std::atomic<uint64_t> counter(0);
+#if defined(_WIN32)
+    long long pid = _getpid();
+#else
+    long long pid = getpid();
+#endif
+    path += "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+    return path;
+}
+
+void PPM_Parser::store_cached(uint64_t key, std::vector<LocalChunk> const &chunks) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ppu", (unsigned long long)key);
+    std::filesystem::path path = std::filesystem::path(cache_directory) / name;
+
+    // Write to a temporary file first so that a concurrent run never reads a partial entry
+    std::filesystem::path temporary = temporary_path(path);
+    {
+        std::ofstream output(temporary, std::ios::binary);
+        write_chunk_compressed("chnk", chunks, &output);
+    }
+    std::filesystem::rename(temporary, path);
+}
+
+SlicedImage PPM_Parser::slice_image_cached(std::string const &filename, std::string *cache_entry) const
+{
+    if (cache_directory.empty())
+    {
+        return slice_image(filename);
+    }
+
+    // The key covers the content of the image and every setting that changes how it is sliced
+    uint64_t key;
+    {
+        MappedFile source(filename);
+        key = hash_bytes(source.data(), source.size(), cache_key_base(chunk_size));
+    }
+
+    SlicedImage sliced;
+    name_image(&sliced, filename);
+    if (load_cached(key, &sliced.chunks, cache_entry))
+    {
+        sliced.cached = true;
+        return sliced;
+    }
+
+    sliced = slice_image(filename);
+    store_cached(key, sliced.chunks);
+
+    return sliced;
+}
+
+std::vector<SlicedImage> PPM_Parser::slice_atlas(AtlasManifest const &manifest, std::vector<std::string> *cache_entries) const
+{
+    // The key of each region covers the content of the image and the position of the region
+    uint64_t image_key = 0;
+    if (!cache_directory.empty())
+    {
+        MappedFile source(manifest.image);
+        image_key = hash_bytes(source.data(), source.size(), cache_key_base(chunk_size));
+    }
+
+    // The image is only loaded if a region isn't cached, and then only once for all the regions
+    PPM_Image image;
+    bool loaded = false;
+
+    std::vector<SlicedImage> sliced(manifest.regions.size());
+    for (size_t i = 0; i < manifest.regions.size(); i++)
+    {
+        AtlasManifest::Region const &region = manifest.regions[i];
+        sliced[i].filename = manifest.filename;
+        sliced[i].name = region.name;
+
+        uint32_t position[4] = {region.x, region.y, region.width, region.height};
+        uint64_t key = hash_bytes(reinterpret_cast<uint8_t const *>(position), sizeof(position), image_key);
+        if (!cache_directory.empty())
+        {
+            cache_entries->emplace_back();
+            if (load_cached(key, &sliced[i].chunks, &cache_entries->back()))
+            {
+                sliced[i].cached = true;
+                continue;
+            }
+        }
+
+        if (!loaded)
+        {
+            image = PPM_Image::load(manifest.image);
+            loaded = true;
+        }
+        try
+        {
+            sliced[i].chunks = slice_region(image, region.x, region.y, region.width, region.height);
+        }
+        catch (std::exception const &e)
+        {
+            throw std::runtime_error("'" + manifest.filename + "': sprite '" + region.name + "': " + e.what() + " '" + manifest.image + "'");
+        }
+        if (!cache_directory.empty())
+        {
+            store_cached(key, sliced[i].chunks);
+        }
+    }
+    return sliced;
+}
+
+void PPM_Parser::register_image(SlicedImage const &sliced)
+{
+    SpriteRange range;
+    range.name = sliced.name;
+    for (SpriteRange const &other : sprite_ranges)
+    {
+        if (other.name == range.name)
+        {
+            throw std::runtime_error("Two sprites are named '" + range.name + "' (the last one comes from '" + sliced.filename + "'), sprite names must be unique");
+        }
+    }
+
+    range.filename = sliced.filename;
+    range.first_tile_ref = uint32_t(tile_refs.size());
+    size_t tiles_before = tile_table.size();
+    for (LocalChunk const &chunk : sliced.chunks)
+    {
+        tile_refs.push_back(register_chunk(chunk));
+        range.colours_lost += chunk.colours_lost;
+    }
+    range.tile_ref_count = uint32_t(tile_refs.size()) - range.first_tile_ref;
+    range.new_tiles = uint32_t(tile_table.size() - tiles_before);
+
+    sprite_ranges.push_back(range);
+}
+
+void PPM_Parser::register_map(SlicedImage const &sliced)
+{
+    MapRange range;
+    range.name = sliced.name;
+    for (MapRange const &other : map_ranges)
+    {
+        if (other.name == range.name)
+        {
+            throw std::runtime_error("Two maps are named '" + range.name + "' (the last one comes from '" + sliced.filename + "'), map names must be unique");
+        }
+    }
+
+    // The map is as large as the chunks covering the image
+    for (LocalChunk const &chunk : sliced.chunks)
+    {
+        range.width = std::max<uint32_t>(range.width, chunk.offset_x_chunk + 1);
+        range.height = std::max<uint32_t>(range.height, chunk.offset_y_chunk + 1);
+    }
+
+    // Entries are stored row by row from the bottom left tile, like PPU466::background
+    range.filename = sliced.filename;
+    range.first_entry = uint32_t(map_tiles.size());
+    map_tiles.resize(map_tiles.size() + size_t(range.width) * range.height);
+    size_t tiles_before = tile_table.size();
+    for (LocalChunk const &chunk : sliced.chunks)
+    {
+        Sprite::TileRef tile_ref = register_chunk(chunk);
+        map_tiles[range.first_entry + size_t(chunk.offset_y_chunk) * range.width + chunk.offset_x_chunk] = uint16_t(tile_ref.tile_index | tile_ref.palette_index << 8);
+        range.colours_lost += chunk.colours_lost;
+    }
+    range.new_tiles = uint32_t(tile_table.size() - tiles_before);
+
+    map_ranges.push_back(range);
+}
+
+void PPM_Parser::parse_image(std::string const &filename)
+{
+    register_image(slice_image(filename));
+}
+
+std::vector<PPM_Parser::SpriteRange const *> PPM_Parser::sorted_sprites() const
+{
+    std::vector<SpriteRange const *> sorted;
+    for (SpriteRange const &range : sprite_ranges)
+    {
+        sorted.push_back(&range);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](SpriteRange const *a, SpriteRange const *b)
+              { return a->name < b->name; });
+    return sorted;
+}
+
+std::vector<PPM_Parser::MapRange const *> PPM_Parser::sorted_maps() const
+{
+    std::vector<MapRange const *> sorted;
+    for (MapRange const &range : map_ranges)
+    {
+        sorted.push_back(&range);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](MapRange const *a, MapRange const *b)
+              { return a->name < b->name; });
+    return sorted;
+}
+
+void PPM_Parser::write_archive(std::string const &filename) const
+{
+    // The table of contents is sorted by name so the game can binary search it
+    std::vector<Sprites::Entry> entries;
+    std::vector<char> names;
+    for (SpriteRange const *range : sorted_sprites())
+    {
+        Sprites::Entry entry;
+        entry.name_offset = uint32_t(names.size());
+        entry.name_length = uint32_t(range->name.size());
+        entry.first_tile_ref = range->first_tile_ref;
+        entry.tile_ref_count = range->tile_ref_count;
+        entries.push_back(entry);
+        names.insert(names.end(), range->name.begin(), range->name.end());
+    }
+
+    // Maps have their own table of contents, their names following the names of the sprites
+    std::vector<Sprites::MapEntry> map_entries;
+    for (MapRange const *range : sorted_maps())
+    {
+        Sprites::MapEntry entry;
+        entry.name_offset = uint32_t(names.size());
+        entry.name_length = uint32_t(range->name.size());
+        entry.first_entry = range->first_entry;
+        entry.width = range->width;
+        entry.height = range->height;
+        map_entries.push_back(entry);
+        names.insert(names.end(), range->name.begin(), range->name.end());
+    }
+
+    // Write to a temporary file first so that the game never maps a partial archive
+    std::string temporary = temporary_path(filename).string();
+    {
+        std::ofstream output(temporary, std::ios::binary);
+        write_chunk_file_header(&output);
+        write_chunk_v2("tile", tile_table, &output);
+        write_chunk_v2("palt", palette_table, &output);
+        write_chunk_v2("sprt", entries, &output);
+        write_chunk_v2("refs", tile_refs, &output);
+        write_chunk_v2("name", names, &output);
+        write_chunk_v2("maps", map_entries, &output);
+        write_chunk_v2("bgnd", map_tiles, &output);
+        if (!output)
+        {
+            throw std::runtime_error("Failed to write the asset archive '" + temporary + "'");
+        }
+    }
+    std::filesystem::rename(temporary, filename);
+}
+
+// Writes a generated source file, leaving it untouched if it already has these contents
+// so that the game isn't rebuilt for nothing
+static void write_if_changed(std::string const &filename, std::string const &contents)
+{
+    {
+        std::ifstream existing(filename, std::ios::binary);
+        std::ostringstream existing_contents;
+        existing_contents << existing.rdbuf();
+        if (existing && existing_contents.str() == contents)
+        {
+            return;
+        }
+    }
+    std::ofstream output(filename, std::ios::binary);
+    output << contents;
+    if (!output)
+    {
+        throw std::runtime_error("Failed to write '" + filename + "'");
+    }
+}
+
+// Turns a sprite name into a valid C++ identifier
+static std::string identifier(std::string const &name)
+{
+    std::string result;
+    for (char c : name)
+    {
+        result += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0])))
+    {
+        result = "_" + result;
+    }
+    // Names that are keywords get a trailing underscore (e.g. void becomes void_)
+    static char const *const Keywords[] = {
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+        "char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const", "consteval", "constexpr",
+        "constinit", "const_cast", "continue", "co_await", "co_return", "co_yield", "decltype", "default", "delete",
+        "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+        "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+        "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast",
+        "requires", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+        "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename",
+        "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq"};
+    for (char const *keyword : Keywords)
+    {
+        if (result == keyword)
+        {
+            result += "_";
+        }
+    }
+    return result;
+}
+
+// Writes an enum giving the index of every name, along with a count and the names indexed by the enum
+static void write_ids(std::ostringstream &header, std::string const &kind, std::vector<std::string> const &names)
+{
+    header << "enum class " << kind << "ID : uint16_t\n{\n";
+    std::vector<std::string> identifiers;
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        std::string id = identifier(names[i]);
+        auto other = std::find(identifiers.begin(), identifiers.end(), id);
+        if (other != identifiers.end())
+        {
+            throw std::runtime_error(kind + "s '" + names[other - identifiers.begin()] + "' and '" + names[i] + "' would have the same ID '" + id + "'");
+        }
+        identifiers.push_back(id);
+        header << "    " << id << " = " << i << ",\n";
+    }
+    header << "};\n\n";
+    header << "constexpr uint16_t " << kind << "Count = " << names.size() << ";\n\n";
+    header << "// Names of the " << (kind == "Sprite" ? "sprites" : "maps") << ", indexed by " << kind << "ID\n";
+    // (a std::array rather than a plain array, since an asset set may have no maps and zero-length arrays aren't C++)
+    header << "constexpr std::array<std::string_view, " << kind << "Count> " << kind << "Names = {\n";
+    for (std::string const &name : names)
+    {
+        header << "    \"";
+        for (char c : name)
+        {
+            header << (c == '"' || c == '\\' ? "\\" : "") << c;
+        }
+        header << "\",\n";
+    }
+    header << "};\n";
+}
+
+void PPM_Parser::write_sprite_ids(std::string const &filename) const
+{
+    std::vector<std::string> sprite_names;
+    for (SpriteRange const *range : sorted_sprites())
+    {
+        sprite_names.push_back(range->name);
+    }
+    std::vector<std::string> map_names;
+    for (MapRange const *range : sorted_maps())
+    {
+        map_names.push_back(range->name);
+    }
+
+    std::ostringstream header;
+    header << "// Generated by parsing/parse_ppm, do not edit.\n";
+    header << "// One ID per sprite and per map of parsing/assets.ppu, in the order of its tables of contents (sorted by name).\n";
+    header << "#pragma once\n\n";
+    header << "#include <array>\n";
+    header << "#include <cstdint>\n";
+    header << "#include <string_view>\n\n";
+    write_ids(header, "Sprite", sprite_names);
+    header << "\n";
+    write_ids(header, "Map", map_names);
+
+    write_if_changed(filename, header.str());
+}
+
+void PPM_Parser::write_embedded_assets(std::string const &filename) const
+{
+    char hex[8];
+    auto byte = [&hex](uint8_t value)
+    {
+        std::snprintf(hex, sizeof(hex), "0x%02x", value);
+        return std::string(hex);
+    };
+
+    std::ostringstream source;
+    source << "// Generated by parsing/parse_ppm, do not edit.\n";
+    source << "// The tables of parsing/assets.ppu as constant data, so the game can start without reading any file.\n";
+    source << "#include \"Sprites.hpp\"\n\n";
+    source << "#include <array>\n\n";
+
+    source << "static constexpr std::array<PPU466::Tile, " << tile_table.size() << "> Tiles = {\n";
+    for (PPU466::Tile const &tile : tile_table)
+    {
+        source << "    PPU466::Tile{{";
+        for (size_t i = 0; i < tile.bit0.size(); i++)
+        {
+            source << (i ? ", " : "") << byte(tile.bit0[i]);
+        }
+        source << "}, {";
+        for (size_t i = 0; i < tile.bit1.size(); i++)
+        {
+            source << (i ? ", " : "") << byte(tile.bit1[i]);
+        }
+        source << "}},\n";
+    }
+    source << "};\n\n";
+
+    source << "static constexpr std::array<PPU466::Palette, " << palette_table.size() << "> Palettes = {\n";
+    for (PPU466::Palette const &palette : palette_table)
+    {
+        source << "    PPU466::Palette{";
+        for (size_t i = 0; i < palette.size(); i++)
+        {
+            source << (i ? ", " : "") << "glm::u8vec4(" << byte(palette[i][RED]) << ", " << byte(palette[i][GREEN]) << ", "
+                   << byte(palette[i][BLUE]) << ", " << byte(palette[i][ALPHA]) << ")";
+        }
+        source << "},\n";
+    }
+    source << "};\n\n";
+
+    std::vector<SpriteRange const *> sorted = sorted_sprites();
+    std::string names;
+    source << "static constexpr std::array<Sprites::Entry, " << sorted.size() << "> Entries = {\n";
+    for (SpriteRange const *range : sorted)
+    {
+        source << "    Sprites::Entry{" << names.size() << ", " << range->name.size() << ", " << range->first_tile_ref << ", " << range->tile_ref_count << "}, // " << range->name << "\n";
+        names += range->name;
+    }
+    source << "};\n\n";
+
+    source << "static constexpr std::array<Sprite::TileRef, " << tile_refs.size() << "> TileRefs = {\n";
+    for (Sprite::TileRef const &tile_ref : tile_refs)
+    {
+        source << "    Sprite::TileRef{" << tile_ref.tile_index << ", " << tile_ref.palette_index << ", " << tile_ref.offset_x_chunk << ", " << tile_ref.offset_y_chunk << "},\n";
+    }
+    source << "};\n\n";
+
+    std::vector<MapRange const *> sorted_map_ranges = sorted_maps();
+    source << "static constexpr std::array<Sprites::MapEntry, " << sorted_map_ranges.size() << "> MapEntries = {\n";
+    for (MapRange const *range : sorted_map_ranges)
+    {
+        source << "    Sprites::MapEntry{" << names.size() << ", " << range->name.size() << ", " << range->first_entry << ", " << range->width << ", " << range->height << "}, // " << range->name << "\n";
+        names += range->name;
+    }
+    source << "};\n\n";
+
+    source << "static constexpr std::array<uint16_t, " << map_tiles.size() << "> MapTiles = {";
+    for (size_t i = 0; i < map_tiles.size(); i++)
+    {
+        source << (i % 16 ? " " : "\n    ") << map_tiles[i] << ",";
+    }
+    source << "\n};\n\n";
+
+    source << "static constexpr char Names[] = \"";
+    for (char c : names)
+    {
+        source << (c == '"' || c == '\\' ? "\\" : "") << c;
+    }
+    source << "\";\n\n";
+
+    source << "std::span<PPU466::Tile const> const EmbeddedAssets::tile_table = Tiles;\n";
+    source << "std::span<PPU466::Palette const> const EmbeddedAssets::palette_table = Palettes;\n";
+    source << "std::span<Sprites::Entry const> const EmbeddedAssets::entries = Entries;\n";
+    source << "std::span<Sprite::TileRef const> const EmbeddedAssets::tile_refs = TileRefs;\n";
+    source << "std::span<char const> const EmbeddedAssets::names = std::span<char const>(Names, sizeof(Names) - 1);\n";
+    source << "std::span<Sprites::MapEntry const> const EmbeddedAssets::map_entries = MapEntries;\n";
+    source << "std::span<uint16_t const> const EmbeddedAssets::map_tiles = MapTiles;\n";
+
+    write_if_changed(filename, source.str());
+}
+
+// Figures shared by the text and JSON reports
+struct ReportTotals
 {
-    std::ifstream file(filename);
+    // Chunks registered (sprite tile refs and map entries), each of which would need its own tile without deduplication
+    size_t chunks = 0;
+    size_t colours_lost = 0;
+    // Number of chunks drawn with each palette
+    std::vector<size_t> palette_chunks;
+    // Largest sprite, in sprite table entries
+    PPM_Parser::SpriteRange const *largest = nullptr;
 
-    // Palette for this sprite
-    PPU466::Palette palette = {};
+    explicit ReportTotals(PPM_Parser const &parser)
+    {
+        palette_chunks.assign(parser.palette_table.size(), 0);
+        for (Sprite::TileRef const &tile_ref : parser.tile_refs)
+        {
+            palette_chunks[tile_ref.palette_index]++;
+        }
+        for (uint16_t entry : parser.map_tiles)
+        {
+            palette_chunks[entry >> 8]++;
+        }
+        chunks = parser.tile_refs.size() + parser.map_tiles.size();
+        for (PPM_Parser::SpriteRange const &range : parser.sprite_ranges)
+        {
+            colours_lost += range.colours_lost;
+            if (!largest || range.tile_ref_count > largest->tile_ref_count)
+            {
+                largest = &range;
+            }
+        }
+        for (PPM_Parser::MapRange const &range : parser.map_ranges)
+        {
+            colours_lost += range.colours_lost;
+        }
+    }
+};
 
-    // Tile this image will be represented as
-    PPU466::Tile tile = {0};
+// Palettes used by a run of tile refs, in increasing order
+static std::vector<uint16_t> palettes_used(Sprite::TileRef const *tile_refs, size_t count)
+{
+    std::vector<uint16_t> palettes;
+    for (size_t i = 0; i < count; i++)
+    {
+        palettes.push_back(tile_refs[i].palette_index);
+    }
+    std::sort(palettes.begin(), palettes.end());
+    palettes.erase(std::unique(palettes.begin(), palettes.end()), palettes.end());
+    return palettes;
+}
 
-    // Jumble the palette so black can be registered.
-    palette[0][RED] = 0xff;
-    palette[1][RED] = 0xff;
-    palette[2][RED] = 0xff;
-    palette[3][RED] = 0xff;
+// Number of distinct entries of a map, which is the number of tiles it uses
+static size_t distinct_entries(uint16_t const *entries, size_t count)
+{
+    std::vector<uint16_t> sorted(entries, entries + count);
+    std::sort(sorted.begin(), sorted.end());
+    return size_t(std::unique(sorted.begin(), sorted.end()) - sorted.begin());
+}
 
-    // Set all alpha colours to 0. If alpha is 0
-    // the colour hasn't yet been set in this palette
-    palette[0][ALPHA] = 0;
-    palette[1][ALPHA] = 0;
-    palette[2][ALPHA] = 0;
-    palette[3][ALPHA] = 0;
+void PPM_Parser::write_report(std::ostream &output) const
+{
+    ReportTotals totals(*this);
+    size_t const TileLimit = std::tuple_size<decltype(PPU466::tile_table)>::value;
+    size_t const PaletteLimit = std::tuple_size<decltype(PPU466::palette_table)>::value;
+    size_t const SpriteLimit = std::tuple_size<decltype(PPU466::sprites)>::value;
 
-    size_t colours_registered = 0;
-    bool to_register = true;
-    uint16_t palette_index = palette_table.size();
+    auto budget = [&output](char const *label, size_t used, size_t limit)
+    {
+        output << (used > limit ? ANSI_COLOR_RED : "") << label << used << " / " << limit << " (" << used * 100 / limit << "%)"
+               << (used > limit ? " over budget" ANSI_COLOR_RESET : "") << "\n";
+    };
+    budget("Tiles:    ", tile_table.size(), TileLimit);
+    budget("Palettes: ", palette_table.size(), PaletteLimit);
+    if (totals.largest)
+    {
+        budget("Largest sprite, in sprite table entries: ", totals.largest->tile_ref_count, SpriteLimit);
+    }
+    output << "Chunks:   " << totals.chunks << ", deduplicated into " << tile_table.size() << " tiles ("
+           << totals.chunks - tile_table.size() << " tiles saved)\n";
+    output << "Colours lost to the 4-colour limit: " << totals.colours_lost << "\n";
 
-    // Indicates what the index of the current pixel's colour is in the palette
+    char line[256];
+    output << "\nSprites (" << sprite_ranges.size() << ")\n";
+    std::snprintf(line, sizeof(line), "  %-24s %8s %8s %8s  %s\n", "name", "chunks", "new", "lost", "palettes");
+    output << line;
+    for (SpriteRange const *range : sorted_sprites())
+    {
+        std::string palettes;
+        for (uint16_t palette : palettes_used(tile_refs.data() + range->first_tile_ref, range->tile_ref_count))
+        {
+            palettes += (palettes.empty() ? "" : " ") + std::to_string(palette);
+        }
+        std::snprintf(line, sizeof(line), "  %-24s %8u %8u %8u  %s\n", range->name.c_str(), range->tile_ref_count, range->new_tiles, range->colours_lost, palettes.c_str());
+        output << line;
+    }
+
+    if (!map_ranges.empty())
+    {
+        output << "\nMaps (" << map_ranges.size() << ")\n";
+        std::snprintf(line, sizeof(line), "  %-24s %8s %8s %8s %8s\n", "name", "size", "tiles", "new", "lost");
+        output << line;
+        for (MapRange const *range : sorted_maps())
+        {
+            std::string size = std::to_string(range->width) + "x" + std::to_string(range->height);
+            std::snprintf(line, sizeof(line), "  %-24s %8s %8zu %8u %8u\n", range->name.c_str(), size.c_str(),
+                          distinct_entries(map_tiles.data() + range->first_entry, size_t(range->width) * range->height), range->new_tiles, range->colours_lost);
+            output << line;
+        }
+    }
 
-    int row = chunk_size - 1;
-    int column = 0;
-    int pixel_count = 0;
+    output << "\nPalettes\n";
+    for (size_t i = 0; i < palette_table.size(); i++)
+    {
+        output << "  " << i << ": " << int(palette_sizes[i]) << " colours, " << totals.palette_chunks[i] << " chunks\n";
+    }
 
-    int R;
-    int G;
-    int B;
+    if (!file_times.empty())
     {
-        while (file >> R >> G >> B)
+        output << "\nFiles\n";
+        for (FileTime const &file : file_times)
         {
-            // Check if the current colour has already been registered in the palette
-            for (size_t i = 0; i <= colours_registered && i < palette.size(); i++)
-            {
-                // If it has, exit the loop
-                if (R == palette[i][RED] && G == palette[i][GREEN] && B == palette[i][BLUE])
-                {
-                    to_register = false;
-                    break;
-                }
-            }
+            std::snprintf(line, sizeof(line), "  %-40s %9.3f ms%s\n", file.filename.c_str(), file.milliseconds, file.cached ? " (cached)" : "");
+            output << line;
+        }
+    }
+}
 
-            // If there is still space in the current palette and a new colour
-            // has been found, add it in the palette.
-            if (colours_registered < palette.size() && to_register)
-            {
-                palette[colours_registered][RED] = R;
-                palette[colours_registered][GREEN] = G;
-                palette[colours_registered][BLUE] = B;
-                // If it is magenta, set alpha to 0
-                palette[colours_registered][ALPHA] = (R == 0xff && G == 0 && B == 0xff) ? 0 : 0xff;
+// Quotes a string for JSON
+static std::string json_string(std::string const &value)
+{
+    std::string result = "\"";
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+            result += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
 
-                colours_registered++;
-            }
-            to_register = true;
+void PPM_Parser::write_report_json(std::ostream &output) const
+{
+    ReportTotals totals(*this);
+
+    output << "{\n";
+    output << "  \"tiles\": {\"used\": " << tile_table.size() << ", \"limit\": " << std::tuple_size<decltype(PPU466::tile_table)>::value
+           << ", \"chunks\": " << totals.chunks << ", \"saved_by_deduplication\": " << totals.chunks - tile_table.size() << "},\n";
+    output << "  \"palettes\": {\"used\": " << palette_table.size() << ", \"limit\": " << std::tuple_size<decltype(PPU466::palette_table)>::value << ", \"table\": [";
+    for (size_t i = 0; i < palette_table.size(); i++)
+    {
+        output << (i ? ", " : "") << "{\"colours\": " << int(palette_sizes[i]) << ", \"chunks\": " << totals.palette_chunks[i] << "}";
+    }
+    output << "]},\n";
+    output << "  \"sprite_table\": {\"limit\": " << std::tuple_size<decltype(PPU466::sprites)>::value
+           << ", \"largest_sprite\": " << (totals.largest ? totals.largest->tile_ref_count : 0) << "},\n";
+    output << "  \"colours_lost\": " << totals.colours_lost << ",\n";
+
+    std::vector<SpriteRange const *> sprites = sorted_sprites();
+    output << "  \"sprites\": [";
+    for (size_t i = 0; i < sprites.size(); i++)
+    {
+        SpriteRange const &range = *sprites[i];
+        output << (i ? ",\n" : "\n") << "    {\"name\": " << json_string(range.name) << ", \"file\": " << json_string(range.filename)
+               << ", \"chunks\": " << range.tile_ref_count << ", \"new_tiles\": " << range.new_tiles << ", \"colours_lost\": " << range.colours_lost << ", \"palettes\": [";
+        std::vector<uint16_t> palettes = palettes_used(tile_refs.data() + range.first_tile_ref, range.tile_ref_count);
+        for (size_t j = 0; j < palettes.size(); j++)
+        {
+            output << (j ? ", " : "") << palettes[j];
+        }
+        output << "]}";
+    }
+    output << (sprites.empty() ? "],\n" : "\n  ],\n");
+
+    std::vector<MapRange const *> maps = sorted_maps();
+    output << "  \"maps\": [";
+    for (size_t i = 0; i < maps.size(); i++)
+    {
+        MapRange const &range = *maps[i];
+        output << (i ? ",\n" : "\n") << "    {\"name\": " << json_string(range.name) << ", \"file\": " << json_string(range.filename)
+               << ", \"width\": " << range.width << ", \"height\": " << range.height
+               << ", \"tiles\": " << distinct_entries(map_tiles.data() + range.first_entry, size_t(range.width) * range.height)
+               << ", \"new_tiles\": " << range.new_tiles << ", \"colours_lost\": " << range.colours_lost << "}";
+    }
+    output << (maps.empty() ? "],\n" : "\n  ],\n");
+
+    output << "  \"files\": [";
+    for (size_t i = 0; i < file_times.size(); i++)
+    {
+        output << (i ? ",\n" : "\n") << "    {\"file\": " << json_string(file_times[i].filename) << ", \"milliseconds\": " << file_times[i].milliseconds
+               << ", \"cached\": " << (file_times[i].cached ? "true" : "false") << "}";
+    }
+    output << (file_times.empty() ? "]\n" : "\n  ]\n");
+    output << "}\n";
+}
+
+void PPM_Parser::parse_directory(std::string const &filename)
+{
+    std::vector<std::string> filenames;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(filename))
+    {
+        if (entry.is_regular_file())
+        {
+            filenames.push_back(entry.path().string());
+        }
+    }
+    std::sort(filenames.begin(), filenames.end());
+
+    // Atlas manifests are read first so that the sheets they cut up aren't also parsed as sprites of their own
+    std::vector<AtlasManifest> manifests;
+    std::vector<std::string> sheets;
+    for (std::string const &name : filenames)
+    {
+        if (std::filesystem::path(name).extension() == ".atlas")
+        {
+            manifests.push_back(AtlasManifest::load(name));
+            sheets.push_back(std::filesystem::path(manifests.back().image).lexically_normal().string());
+        }
+    }
+
+    // One job per standalone image or atlas, in path order
+    struct Job
+    {
+        std::string image;
+        AtlasManifest const *manifest = nullptr;
+    };
+    std::vector<Job> jobs;
+    for (size_t i = 0, atlas = 0; i < filenames.size(); i++)
+    {
+        if (std::filesystem::path(filenames[i]).extension() == ".atlas")
+        {
+            jobs.push_back(Job{"", &manifests[atlas++]});
+        }
+        else if (std::find(sheets.begin(), sheets.end(), std::filesystem::path(filenames[i]).lexically_normal().string()) == sheets.end())
+        {
+            jobs.push_back(Job{filenames[i], nullptr});
         }
+    }
+
+    if (!cache_directory.empty())
+    {
+        std::filesystem::create_directories(cache_directory);
+    }
 
-        // Search if the palette has already been registered and get its index in the palette table (default is last spot)
-        // Also check if the current palette is contained in or contains another palette (using the alpha channel)
-        bool palette_found = false;
-        for (size_t i = 0; i < palette_table.size(); i++)
+    // Slice all the jobs in parallel, each worker taking the next job not yet claimed
+    std::vector<std::vector<SlicedImage>> job_sliced(jobs.size());
+    std::vector<std::vector<std::string>> job_cache_entries(jobs.size());
+    std::vector<FileTime> job_times(jobs.size());
+    std::vector<std::exception_ptr> errors(jobs.size());
+    std::atomic<size_t> next_job(0);
+    auto slice_images = [&]()
+    {
+        for (size_t i = next_job++; i < jobs.size(); i = next_job++)
         {
-            int nb_colours_found = 0;
-            for (glm::u8vec4 colour : palette)
+            auto before = std::chrono::high_resolution_clock::now();
+            try
             {
-                // If the colour we are checking has an alpha channel that is null,
-                // it means we found all the previous colours of palette in the other
-                // palette and that palette is contained in the other palette.
-                // If the colour is magenta, allow it to be transparent.
-                if (colour[ALPHA] == 0 && (colour[RED] != 0xff || colour[GREEN] != 0 || colour[BLUE] != 0xff))
-                {
-                    nb_colours_found = palette.size();
-                    palette = palette_table[i];
-                    break;
-                }
-                bool colour_found = false;
-                int colour_index = 0;
-                for (glm::u8vec4 &registered_colour : palette_table[i])
+                if (jobs[i].manifest)
                 {
-                    if (colour[RED] == registered_colour[RED] && colour[GREEN] == registered_colour[GREEN] && colour[BLUE] == registered_colour[BLUE] && colour[ALPHA] == registered_colour[ALPHA])
-                    {
-                        colour_found = true;
-                        break;
-                    }
-                    // If there is space in a registered palette, add your colours to it
-                    // But only if the rest of palette can fit
-                    if (nb_colours_found >= colour_index && registered_colour[ALPHA] == 0 && (registered_colour[RED] != 0xff || registered_colour[GREEN] != 0 || registered_colour[BLUE] != 0xff))
-                    {
-                        colour[ALPHA] = 0xff;
-                        registered_colour = colour;
-                        colour_found = true;
-                        break;
-                    }
-                    colour_index ++;
-                }
-                if (!colour_found)
-                {
-                    break;
+                    job_sliced[i] = slice_atlas(*jobs[i].manifest, &job_cache_entries[i]);
                 }
                 else
                 {
-                    nb_colours_found++;
-                    colour_found = false;
+                    job_cache_entries[i].emplace_back();
+                    job_sliced[i].push_back(slice_image_cached(jobs[i].image, &job_cache_entries[i].back()));
                 }
             }
-            if (nb_colours_found == palette.size())
-            {
-                palette_index = i;
-                palette_found = true;
-                break;
-            }
-            else
+            catch (...)
             {
-                nb_colours_found = 0;
+                errors[i] = std::current_exception();
             }
+            auto after = std::chrono::high_resolution_clock::now();
+            job_times[i].filename = jobs[i].manifest ? jobs[i].manifest->filename : jobs[i].image;
+            job_times[i].milliseconds = std::chrono::duration<double, std::milli>(after - before).count();
+            job_times[i].cached = std::all_of(job_sliced[i].begin(), job_sliced[i].end(), [](SlicedImage const &sliced)
+                                              { return sliced.cached; });
+        }
+    };
+
+    size_t nb_workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), jobs.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < nb_workers; i++)
+    {
+        workers.emplace_back(slice_images);
+    }
+    slice_images();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (std::exception_ptr const &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Flatten the results, keeping the order of the jobs
+    std::vector<SlicedImage> sliced;
+    std::vector<std::string> cache_entries;
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        std::move(job_sliced[i].begin(), job_sliced[i].end(), std::back_inserter(sliced));
+        std::move(job_cache_entries[i].begin(), job_cache_entries[i].end(), std::back_inserter(cache_entries));
+    }
+    job_sliced.clear();
+    file_times = std::move(job_times);
+
+    pack_palettes(sliced);
+
+    // Registering changes the shared tables, so it is done serially in path order
+    for (size_t i = 0; i < sliced.size(); i++)
+    {
+        if (sliced[i].map)
+        {
+            register_map(sliced[i]);
         }
-        if (!palette_found)
+        else
         {
-            palette_table.push_back(palette);
-            palette_index = palette_table.size() - 1;
+            register_image(sliced[i]);
         }
+        // Release the image as soon as it has been registered
+        sliced[i] = SlicedImage();
     }
 
-    file.close();
-    file.open(filename);
-    // Make sure to only parse the pixels in the image
+    // Writing the parsed data to a single archive to be mapped by the game
+    write_archive(output_directory + "/assets.ppu");
+    write_sprite_ids(output_directory + "/sprite_ids.hpp");
+    write_embedded_assets(output_directory + "/embedded_assets.cpp");
+
+    // Remove the cache entries of images that no longer exist or have changed
+    if (!cache_directory.empty())
     {
-        size_t colour_index = 0;
-        while (file >> R >> G >> B && pixel_count < chunk_size * chunk_size)
+        std::sort(cache_entries.begin(), cache_entries.end());
+        for (const auto &entry : std::filesystem::directory_iterator(cache_directory))
         {
-            // Find the current colour in the palette
-            for (size_t i = 0; i <= colours_registered && i < palette.size(); i++)
+            // Temporary files may be entries another run is writing right now, so they are only removed
+            // once they are old enough to have been left behind by a run that was interrupted
+            if (entry.path().extension() == ".tmp")
             {
-                if (R == palette[i][RED] && G == palette[i][GREEN] && B == palette[i][BLUE])
+                std::error_code error;
+                auto written = std::filesystem::last_write_time(entry.path(), error);
+                if (!error && std::filesystem::file_time_type::clock::now() - written > std::chrono::hours(1))
                 {
-                    colour_index = i;
-                    break;
+                    std::filesystem::remove(entry.path(), error);
                 }
+                continue;
+            }
+            if (!std::binary_search(cache_entries.begin(), cache_entries.end(), entry.path().filename().string()))
+            {
+                std::filesystem::remove(entry.path());
             }
-
-            // Add the pixel to the tile
-            tile.bit0[row] += (colour_index % 2) << column;
-            tile.bit1[row] += ((colour_index >> 1) % 2) << column;
-            pixel_count++;
-            column = (column + 1);
-            row -= column / chunk_size;
-            column %= chunk_size;
         }
     }
+}
 
-    // Constructing the tile ref for our new tile
-    Sprite::TileRef tile_ref = {0};
+// Times the scalar and vectorised versions of gather_chunk on a synthetic 4096x4096 atlas
+// and checks that they produce the same chunks
+static void benchmark_gather()
+{
+    constexpr uint32_t Size = 4096;
+    PPM_Parser parser;
 
-    tile_ref.palette_index = palette_index;
-    tile_ref.tile_index = tile_table.size();
-    tile_ref.offset_x_chunk = 0; // Is set to 0 by default
-    tile_ref.offset_y_chunk = 0; // Modified in parse_image if needed
+    // Each chunk uses up to four colours from a small set, like pixel art does
+    std::vector<uint8_t> atlas(size_t(Size) * Size * 3);
+    std::mt19937 rng(466);
+    for (uint32_t chunk_y = 0; chunk_y < Size; chunk_y += parser.chunk_size)
+    {
+        for (uint32_t chunk_x = 0; chunk_x < Size; chunk_x += parser.chunk_size)
+        {
+            std::array<uint32_t, 4> colours;
+            for (uint32_t &colour : colours)
+            {
+                colour = rng() % 32 == 0 ? 0xff00ff : rng() % 16 * 0x0f0f0f;
+            }
+            uint32_t nb_colours = 1 + rng() % 4;
+            for (uint32_t y = 0; y < parser.chunk_size; y++)
+            {
+                for (uint32_t x = 0; x < parser.chunk_size; x++)
+                {
+                    uint32_t colour = colours[rng() % nb_colours];
+                    uint8_t *pixel = &atlas[(size_t(chunk_y + y) * Size + chunk_x + x) * 3];
+                    pixel[RED] = colour >> 16;
+                    pixel[GREEN] = colour >> 8;
+                    pixel[BLUE] = colour;
+                }
+            }
+        }
+    }
 
-    tile_refs.push_back(tile_ref);
+    auto run = [&](bool vectorised, std::vector<LocalChunk> *chunks)
+    {
+        parser.vectorised = vectorised;
+        chunks->clear();
+        chunks->reserve(size_t(Size / parser.chunk_size) * (Size / parser.chunk_size));
+        auto before = std::chrono::high_resolution_clock::now();
+        for (uint32_t chunk_y = 0; chunk_y < Size; chunk_y += parser.chunk_size)
+        {
+            for (uint32_t chunk_x = 0; chunk_x < Size; chunk_x += parser.chunk_size)
+            {
+                ChunkView view;
+                view.pixels = &atlas[(size_t(chunk_y) * Size + chunk_x) * 3];
+                view.row_stride = size_t(Size) * 3;
+                chunks->push_back(parser.gather_chunk(view));
+            }
+        }
+        auto after = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(after - before).count();
+    };
+
+    std::vector<LocalChunk> scalar, vectorised;
+    double scalar_time = run(false, &scalar);
+    double vectorised_time = run(true, &vectorised);
 
-    tile_table.push_back(tile);
+    bool same = scalar.size() == vectorised.size() && std::memcmp(scalar.data(), vectorised.data(), scalar.size() * sizeof(LocalChunk)) == 0;
+    double megabytes = atlas.size() / (1024.0 * 1024.0);
+    std::cout << "Gathering " << scalar.size() << " chunks of a " << Size << "x" << Size << " atlas:" << std::endl;
+    std::cout << "    scalar:     " << scalar_time * 1000.0 << " ms (" << megabytes / scalar_time << " MB/s)" << std::endl;
+    std::cout << "    vectorised: " << vectorised_time * 1000.0 << " ms (" << megabytes / vectorised_time << " MB/s)" << std::endl;
+    std::cout << (same ? ANSI_COLOR_GREEN "Both versions produce the same chunks." : ANSI_COLOR_RED "The versions produce different chunks!") << ANSI_COLOR_RESET << std::endl;
 }
 
-void PPM_Parser::parse_image(std::string const &filename, std::string const &output_file)
+// Parses ./sprites from scratch with each chunk kernel, then twice through an empty cache (filling it, then reading it back),
+// and checks that every run writes exactly the archive and sources checked in under ./parsing.
+// Returns false (after listing the differences) if any output changed.
+static bool check_outputs()
 {
-    std::ifstream in_file(filename);
-    std::ofstream out_file(output_file, std::ios_base::app);
-
-    char trash[2];
-    in_file.read(trash, 2); // Read the header of the ppm file (P3)
-
-    int width, height, colours;
-    in_file >> width >> height >> colours;
+    std::filesystem::path scratch = temporary_path(std::filesystem::temp_directory_path() / "parse_ppm_check");
+    std::filesystem::path cache = scratch / "cache";
 
-    // Number of chunks in the image
-    uint8_t chunks_in_row = width % chunk_size == 0 ? (width / chunk_size) : (width / chunk_size) + 1;
-    uint8_t chunks_in_column = height % chunk_size == 0 ? (height / chunk_size) : (height / chunk_size) + 1;
-
-    // Coordinates in the image's chunks
-    uint8_t chunks_parsed_row = 0;
-    uint8_t chunks_parsed_column = 0;
+    struct Run
+    {
+        std::string name;
+        bool vectorised;
+        bool cached;
+        // Whether every image must come from the cache
+        bool hits;
+    };
+    std::vector<Run> const runs = {
+        {"vectorised", true, false, false},
+        {"scalar", false, false, false},
+        {"filling the cache", true, true, false},
+        {"from the cache", true, true, true},
+    };
+    std::vector<std::string> const outputs = {"assets.ppu", "sprite_ids.hpp", "embedded_assets.cpp"};
 
-    // Pixels seen since the begining of the line in the current chunk
-    uint8_t pixels_seen = 0;
-    // Lines passed since the begining of the parsing operation on the current chunk
-    uint8_t lines_passed = 0;
+    auto read_file = [](std::filesystem::path const &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return file ? contents.str() : std::string();
+    };
 
-    // Go through the image and write it chunk by chunk into the parsing file
-    // so that each chunk gets parsed individually
-    int R, G, B;
-    while (chunks_parsed_column < chunks_in_column)
+    bool same = true;
+    for (size_t i = 0; i < runs.size(); i++)
     {
-        in_file >> R >> G >> B;
+        std::filesystem::path output = scratch / std::to_string(i);
+        std::filesystem::create_directories(output);
+
+        PPM_Parser parser;
+        parser.vectorised = runs[i].vectorised;
+        parser.cache_directory = runs[i].cached ? cache.string() : "";
+        parser.output_directory = output.string();
+        parser.parse_directory("./sprites");
 
-        if (pixels_seen < chunk_size)
+        std::vector<std::string> problems;
+        if (runs[i].hits && !std::all_of(parser.file_times.begin(), parser.file_times.end(), [](PPM_Parser::FileTime const &time)
+                                         { return time.cached; }))
         {
-            out_file << R << " " << G << " " << B << std::endl;
-            pixels_seen += 1;
+            problems.push_back("some images were sliced again instead of read from the cache");
         }
-        if (pixels_seen >= chunk_size)
+        for (std::string const &name : outputs)
         {
-            lines_passed += 1;
-
-            if (lines_passed >= chunk_size)
+            std::string expected = read_file(std::filesystem::path("./parsing") / name);
+            if (expected.empty() || read_file(output / name) != expected)
             {
-                lines_passed = 0;
-
-                parse_chunk(output_file);
-
-                tile_refs.back().offset_x_chunk = chunks_parsed_row;
-
-                // The file is read from top left to bottom right
-                // but the sprite is displayed from bottom left to top right
-                tile_refs.back().offset_y_chunk = chunks_in_column - 1 - chunks_parsed_column;
+                problems.push_back("parsing/" + name + " differs");
+            }
+        }
 
-                chunks_parsed_row += 1;
+        if (problems.empty())
+        {
+            std::cout << ANSI_COLOR_GREEN << "Parsing " << runs[i].name << ": same outputs." << ANSI_COLOR_RESET << std::endl;
+        }
+        for (std::string const &problem : problems)
+        {
+            std::cout << ANSI_COLOR_RED << "Parsing " << runs[i].name << ": " << problem << ANSI_COLOR_RESET << std::endl;
+        }
+        same = same && problems.empty();
+    }
 
-                // Empty all the text from the output file to make space for the new chunk.
-                out_file.close();
-                std::remove(output_file.c_str());
-                out_file.open(output_file, std::ios_base::app);
+    std::error_code error;
+    std::filesystem::remove_all(scratch, error);
+    if (!same)
+    {
+        std::cout << "If the change is intended, run parse_ppm and commit the regenerated files under parsing/." << std::endl;
+    }
+    return same;
+}
 
-                // Don't need to move the cursor if we've just finished a line
-                if (chunks_parsed_row != chunks_in_row)
-                {
-                    // Re-open the file and start from the begining
-                    in_file.close();
-                    in_file.open(filename);
+// Watches a directory (and its subdirectories) for changes from its creation on,
+// so changes made while the sprites are being parsed are not missed
+struct DirectoryWatcher
+{
+    explicit DirectoryWatcher(std::string const &directory_);
+    ~DirectoryWatcher();
+    DirectoryWatcher(DirectoryWatcher const &) = delete;
+    DirectoryWatcher &operator=(DirectoryWatcher const &) = delete;
 
-                    char trash[2];
-                    in_file.read(trash, 2); // Read the header of the ppm file (P3)
+    // Blocks until something changed since the last call (or since the watcher was created)
+    void wait();
 
-                    int width, height, colours;
-                    in_file >> width >> height >> colours;
+    std::string directory;
+#if defined(__linux__)
+    int notify = -1;
+    // inotify doesn't watch subdirectories, so each one gets its own watch
+    void add_watches();
+#else
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> snapshot() const;
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> last_snapshot;
+#endif
+};
 
-                    // Number of pixels until new line in chunk
-                    uint8_t pixels_to_chunk = width * chunks_parsed_column * chunk_size + chunk_size * chunks_parsed_row;
+#if defined(__linux__)
+DirectoryWatcher::DirectoryWatcher(std::string const &directory_) : directory(directory_)
+{
+    notify = inotify_init1(IN_CLOEXEC);
+    if (notify < 0)
+    {
+        throw std::runtime_error("Failed to start watching '" + directory + "'");
+    }
+    add_watches();
+}
 
-                    // Navigate to new chunk line
-                    while (pixels_to_chunk > 0 && in_file >> R >> G >> B)
-                    {
-                        pixels_to_chunk--;
-                    }
-                }
-            }
-            else
-            {
-                // Number of pixels until new line in chunk
-                uint8_t pixels_to_chunk = width - pixels_seen;
-                // Navigate to new chunk line
-                while (pixels_to_chunk > 0 && in_file >> R >> G >> B)
-                {
-                    pixels_to_chunk--;
-                }
-            }
+DirectoryWatcher::~DirectoryWatcher()
+{
+    close(notify);
+}
 
-            pixels_seen = 0;
-        }
-        if (chunks_parsed_row >= chunks_in_row)
+void DirectoryWatcher::add_watches()
+{
+    // Adding a watch again for a directory already watched keeps the same watch
+    uint32_t const Events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+    inotify_add_watch(notify, directory.c_str(), Events);
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (entry.is_directory())
         {
-            chunks_parsed_column += 1;
-            chunks_parsed_row = 0;
+            inotify_add_watch(notify, entry.path().c_str(), Events);
         }
     }
+}
 
-    std::string sprite_name = std::filesystem::path(filename).stem();
+void DirectoryWatcher::wait()
+{
+    // Events queued while the sprites were being parsed end the wait at once.
+    // Otherwise wait for a first event, then for editors to be done saving (no event for 100ms).
+    char events[4096];
+    pollfd watched = {notify, POLLIN, 0};
+    bool changed = false;
+    while (poll(&watched, 1, changed ? 100 : -1) > 0)
+    {
+        changed = read(notify, events, sizeof(events)) > 0 || changed;
+    }
+    // Subdirectories created since the last call are watched from now on
+    add_watches();
+}
+#else
+DirectoryWatcher::DirectoryWatcher(std::string const &directory_) : directory(directory_), last_snapshot(snapshot())
+{
+}
 
-    std::ofstream output("./parsing/sprites/" + sprite_name + ".ppu", std::ios::binary);
-    write_chunk("refs", tile_refs, &output);
+DirectoryWatcher::~DirectoryWatcher()
+{
+}
 
-    // Empty the references
-    tile_refs = {};
+std::vector<std::pair<std::string, std::filesystem::file_time_type>> DirectoryWatcher::snapshot() const
+{
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> files;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        files.emplace_back(entry.path().string(), entry.last_write_time());
+    }
+    return files;
 }
 
-void PPM_Parser::parse_directory(std::string const &filename)
+void DirectoryWatcher::wait()
 {
-    for (const auto &entry : std::filesystem::recursive_directory_iterator(filename))
+    // Without inotify, poll the modification times of every file a few times per second,
+    // comparing them to the times of the last change (so changes made while parsing are seen at once)
+    auto files = snapshot();
+    while (files == last_snapshot)
     {
-        parse_image(entry.path(), "parsing/tmp_chunk.txt");
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        files = snapshot();
     }
+    last_snapshot = std::move(files);
+}
+#endif
+
+// What to print once the sprites are parsed
+enum class ReportFormat
+{
+    None,
+    Text,
+    Json
+};
 
-    std::ofstream output("./parsing/tables.ppu");
+static void print_report(PPM_Parser const &parser, ReportFormat format)
+{
+    if (format == ReportFormat::Text)
+    {
+        parser.write_report(std::cout);
+    }
+    else if (format == ReportFormat::Json)
+    {
+        parser.write_report_json(std::cout);
+    }
+}
 
-    // Writing the parsed data to files to be read by the game
-    write_chunk("tile", tile_table, &output);
-    write_chunk("palt", palette_table, &output);
+// Parses the directory again every time one of its images changes, until interrupted.
+// Each run starts from empty tables, but unchanged images are taken from the cache, so only edited images are parsed again.
+static void watch_directory(PPM_Parser const &settings, std::string const &directory, ReportFormat report)
+{
+    // Created before the first parse and kept for the whole loop
+    DirectoryWatcher watcher(directory);
+    while (true)
+    {
+        PPM_Parser parser;
+        parser.cache_directory = settings.cache_directory;
+        parser.vectorised = settings.vectorised;
+        try
+        {
+            auto before = std::chrono::high_resolution_clock::now();
+            parser.parse_directory(directory);
+            auto after = std::chrono::high_resolution_clock::now();
+            std::cout << ANSI_COLOR_GREEN << "Rebuilt " << parser.sprite_ranges.size() << " sprites and " << parser.map_ranges.size() << " maps in "
+                      << std::chrono::duration<double, std::milli>(after - before).count() << " ms" << ANSI_COLOR_RESET << std::endl;
+            print_report(parser, report);
+        }
+        catch (std::exception const &e)
+        {
+            // Keep watching, the next save may fix the error
+            std::cerr << ANSI_COLOR_RED << "Error: " << e.what() << ANSI_COLOR_RESET << std::endl;
+        }
+        watcher.wait();
+    }
 }
 
-int main()
+int main(int argc, char **argv)
 {
     PPM_Parser parser;
-    parser.parse_directory("./sprites");
-    // parser.parse_image("./sprites/flower.ppm", "parsing/tmp_chunk.txt");
+    bool watch = false;
+    ReportFormat report = ReportFormat::None;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        // Ignore the cache and parse every image from scratch
+        if (arg == "--no-cache")
+        {
+            parser.cache_directory = "";
+        }
+        // Keep running and parse the sprites again whenever they change
+        else if (arg == "--watch")
+        {
+            watch = true;
+        }
+        // Print how much of the PPU's budget the assets use, as text or as JSON
+        else if (arg == "--report")
+        {
+            report = ReportFormat::Text;
+        }
+        else if (arg == "--report-json")
+        {
+            report = ReportFormat::Json;
+        }
+        // Compare the scalar and vectorised chunk kernels instead of parsing
+        else if (arg == "--benchmark")
+        {
+            benchmark_gather();
+            return 0;
+        }
+        // Check that parsing the sprites (with either kernel, with or without the cache) still writes the checked in files
+        else if (arg == "--check")
+        {
+            try
+            {
+                return check_outputs() ? 0 : 1;
+            }
+            catch (std::exception const &e)
+            {
+                std::cerr << ANSI_COLOR_RED << "Error: " << e.what() << ANSI_COLOR_RESET << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--no-cache] [--watch] [--report | --report-json] [--benchmark] [--check]" << std::endl;
+            return 1;
+        }
+    }
+    try
+    {
+        if (watch)
+        {
+            watch_directory(parser, "./sprites", report);
+        }
+        else
+        {
+            parser.parse_directory("./sprites");
+            print_report(parser, report);
+        }
+    }
+    catch (std::exception const &e)
+    {
+        std::cerr << ANSI_COLOR_RED << "Error: " << e.what() << ANSI_COLOR_RESET << std::endl;
+        return 1;
+    }
+    // parser.parse_image("./sprites/flower.ppm");
 }
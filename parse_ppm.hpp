@@ -4,24 +4,286 @@
 #include <vector>
 #include <stdint.h>
 #include <map>
+#include <unordered_map>
+#include <array>
+#include <ostream>
 
 #include "PPU466.hpp"
 #include "Sprites.hpp"
+#include "mapped_file.hpp"
+
+// An image in memory, as 8 bit pixels stored row by row from the top left.
+// PPM images have RGB pixels where magenta means transparent, PNG images have RGBA pixels.
+struct PPM_Image
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // 3 for RGB pixels, 4 for RGBA pixels
+    uint8_t channels = 3;
+
+    // First pixel of the top row and number of bytes between the start of two rows
+    uint8_t const *pixels = nullptr;
+    size_t row_stride = 0;
+
+    // Binary (P6) images are mapped and their pixels point directly into the file
+    MappedFile mapping;
+    // ASCII (P3) images are decoded into this buffer
+    std::vector<uint8_t> storage;
+    // PNG images are decoded into this buffer
+    std::vector<glm::u8vec4> png_storage;
+
+    // Reads a PPM P6 or P3 image or a PNG image (throws on failure)
+    static PPM_Image load(std::string const &filename);
+};
+
+// A view over an 8x8 chunk of pixels in an image (no pixels are copied)
+struct ChunkView
+{
+    // Top left pixel of the chunk
+    uint8_t const *pixels = nullptr;
+    // Number of bytes between the start of two consecutive rows
+    size_t row_stride = 0;
+    // 3 for RGB pixels (magenta is transparent), 4 for RGBA pixels
+    uint8_t channels = 3;
+
+    uint8_t const *at(uint32_t x, uint32_t y) const { return pixels + y * row_stride + x * channels; }
+};
+
+// A chunk reduced to its own palette (colours in the order they first appear, only the first four are kept)
+// and a tile whose colour indices point into that palette. It doesn't depend on the tables,
+// so chunks can be gathered in parallel and cached between runs.
+struct LocalChunk
+{
+    PPU466::Palette palette;
+    PPU466::Tile tile;
+    uint8_t colours_registered = 0;
+    // Number of distinct colours of the chunk that didn't fit in its four colours (at most 60)
+    uint8_t colours_lost = 0;
+    // Position relative to the bottom left chunk of the image
+    int16_t offset_x_chunk = 0;
+    int16_t offset_y_chunk = 0;
+};
+static_assert(sizeof(LocalChunk) == 38, "LocalChunk is packed");
+
+// An image cut into chunks that have not yet been registered in the tables.
+// Slicing only reads the image, so several images can be sliced at the same time.
+struct SlicedImage
+{
+    // Image (or atlas manifest) the chunks come from
+    std::string filename;
+    // Name of the sprite: the stem of the image, or the name given in the atlas manifest
+    std::string name;
+    // Whether the image is a background map (named <name>.map.ppm or <name>.map.png) rather than a sprite
+    bool map = false;
+    // Whether the chunks were read from the cache instead of being sliced
+    bool cached = false;
+    std::vector<LocalChunk> chunks;
+};
+
+// A manifest cutting a single image into many sprites. Manifests are text files with the .atlas extension:
+//  # comment
+//  image <image path, relative to the manifest>
+//  sprite <name> <x> <y> <width> <height>
+//  strip <name> <x> <y> <frame width> <height> <frame count>
+// Positions are in pixels from the top left corner of the image. A strip is a row of animation frames
+// laid out from left to right, which become the sprites <name>_0, <name>_1, ...
+struct AtlasManifest
+{
+    std::string filename;
+    std::string image;
+
+    struct Region
+    {
+        std::string name;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+    std::vector<Region> regions;
+
+    // Reads a manifest (throws with the line of the error if it is malformed)
+    static AtlasManifest load(std::string const &filename);
+};
+
+// Hash and equality of tiles over their bit planes, so identical tiles can be found in the tile table
+struct TileHash
+{
+    size_t operator()(PPU466::Tile const &tile) const;
+};
+struct TileEqual
+{
+    bool operator()(PPU466::Tile const &a, PPU466::Tile const &b) const;
+};
+
+// A set of up to four RGBA colours (packed in 32 bits) in sorted order,
+// so that palettes holding the same colours in any order have the same key
+struct ColourSet
+{
+    std::array<uint32_t, 4> colours = {};
+    uint8_t count = 0;
+
+    bool operator==(ColourSet const &other) const { return count == other.count && colours == other.colours; }
+};
+struct ColourSetHash
+{
+    size_t operator()(ColourSet const &set) const;
+};
 
 struct PPM_Parser
 {
     std::vector<PPU466::Palette> palette_table;
     std::vector<PPU466::Tile> tile_table;
+    // Tile refs of all the registered sprites, one sprite after the other
     std::vector<Sprite::TileRef> tile_refs;
 
+    // A registered sprite and the range of its tile refs in tile_refs
+    struct SpriteRange
+    {
+        std::string name;
+        uint32_t first_tile_ref = 0;
+        uint32_t tile_ref_count = 0;
+        // For the report: where the sprite comes from, the tiles it added to the tile table
+        // (the others were shared with sprites registered before it) and the colours lost by its chunks
+        std::string filename;
+        uint32_t new_tiles = 0;
+        uint32_t colours_lost = 0;
+    };
+    std::vector<SpriteRange> sprite_ranges;
+
+    // Entries of all the registered background maps, one map after the other, in the layout of
+    // PPU466::background (bits 0-7: tile index, bits 8-10: palette index)
+    std::vector<uint16_t> map_tiles;
+
+    // A registered background map (in tiles) and the range of its entries in map_tiles
+    struct MapRange
+    {
+        std::string name;
+        uint32_t first_entry = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // For the report, as in SpriteRange
+        std::string filename;
+        uint32_t new_tiles = 0;
+        uint32_t colours_lost = 0;
+    };
+    std::vector<MapRange> map_ranges;
+
+    // Time taken to slice each file (image or atlas manifest) by the last parse_directory, for the report
+    struct FileTime
+    {
+        std::string filename;
+        double milliseconds = 0.0;
+        // Whether all the chunks of the file came from the cache
+        bool cached = false;
+    };
+    std::vector<FileTime> file_times;
+
+    // Index of every tile in the tile table, so duplicated chunks share a single tile
+    std::unordered_map<PPU466::Tile, uint16_t, TileHash, TileEqual> tile_indices;
+
+    // Number of colours used by each palette in the palette table (the remaining slots are free)
+    std::vector<uint8_t> palette_sizes;
+    // Every subset of the colours of every registered palette, mapped to the palettes containing it in the order
+    // they got it (at most the whole palette budget). A palette has at most 16 subsets, so looking a chunk's
+    // colours up costs the same whatever the table size.
+    std::unordered_map<ColourSet, std::vector<uint16_t>, ColourSetHash> palette_subsets;
+
     uint8_t chunk_size = 8;
 
-    // Parses an 8x8 chunk of pixels in PPM P3 format (RGB 8 bit colours)
-    void parse_chunk(std::string const &filename);
+    // Number of palettes the PPU466 can hold
+    size_t palette_budget = std::tuple_size<decltype(PPU466::palette_table)>::value;
+
+    // Directory where the chunks of each source image are cached, keyed on the image's content.
+    // Empty to always parse every image.
+    std::string cache_directory = "./parsing/cache";
+
+    // Directory where parse_directory writes the asset archive and the generated sources
+    std::string output_directory = "./parsing";
+
+    // Parses an 8x8 chunk of pixels (RGB 8 bit colours)
+    void parse_chunk(ChunkView const &chunk);
+
+    // Gathers the colours and local tile of a chunk without touching the tables.
+    // 8x8 chunks with at most four colours go through a vectorised kernel, other chunks through gather_chunk_scalar.
+    LocalChunk gather_chunk(ChunkView const &chunk) const;
+
+    // Pixel by pixel version of gather_chunk, handling any chunk size and chunks with more than four colours
+    LocalChunk gather_chunk_scalar(ChunkView const &chunk) const;
+
+    // Set to false to always use gather_chunk_scalar
+    bool vectorised = true;
+
+    // Returns the index of a registered palette holding all the colours of a chunk,
+    // adding the colours to a palette with free slots or registering a new palette if needed
+    uint16_t register_palette(LocalChunk const &chunk);
+
+    // Packs the colours of all the chunks of the given images into as few palettes as possible
+    // and registers them, so that every chunk then finds a palette containing all its colours.
+    // Throws an error naming the sprites that don't fit if more than palette_budget palettes are needed.
+    void pack_palettes(std::vector<SlicedImage> const &images);
+
+    // Adds all the subsets of a registered palette's colours to palette_subsets
+    void index_palette(uint16_t palette_index);
+
+    // Registers a chunk in the palette and tile tables and returns its tile ref
+    Sprite::TileRef register_chunk(LocalChunk const &chunk);
+
+    // Cuts a rectangle of an image (in pixels from its top left corner) into chunks
+    std::vector<LocalChunk> slice_region(PPM_Image const &image, uint32_t left, uint32_t top, uint32_t width, uint32_t height) const;
+
+    // Loads a PPM image and cuts it into chunks (does not modify the parser)
+    SlicedImage slice_image(std::string const &filename) const;
+
+    // Same as slice_image, but reuses the chunks cached for an image with the same content if there are some.
+    // The name of the cache entry used is stored in cache_entry.
+    SlicedImage slice_image_cached(std::string const &filename, std::string *cache_entry) const;
+
+    // Loads the image of an atlas once and cuts every region of its manifest into chunks, one sprite per region.
+    // Each region is cached on its own, and the names of the cache entries used are added to cache_entries.
+    std::vector<SlicedImage> slice_atlas(AtlasManifest const &manifest, std::vector<std::string> *cache_entries) const;
+
+    // Reads the chunks cached under a key into chunks, returning false if there are none.
+    // The name of the cache entry is stored in cache_entry.
+    bool load_cached(uint64_t key, std::vector<LocalChunk> *chunks, std::string *cache_entry) const;
+
+    // Caches chunks under a key
+    void store_cached(uint64_t key, std::vector<LocalChunk> const &chunks) const;
+
+    // Registers all the chunks of a sliced image as a sprite (throws if the name is taken)
+    void register_image(SlicedImage const &sliced);
+
+    // Registers all the chunks of a sliced image as a background map (throws if the name is taken).
+    // Identical tiles are shared with the sprites and within the map, so a map costs its distinct tiles.
+    void register_map(SlicedImage const &sliced);
+
+    // Takes a given PPM image, parses it and registers it as a sprite
+    void parse_image(std::string const &filename);
+
+    // The registered sprites sorted by name, which is their order in the archive and their ID
+    std::vector<SpriteRange const *> sorted_sprites() const;
+
+    // The registered maps sorted by name, which is their order in the archive and their ID
+    std::vector<MapRange const *> sorted_maps() const;
+
+    // Writes the tables and all the registered sprites to a single asset archive (see Sprites in Sprites.hpp)
+    void write_archive(std::string const &filename) const;
+
+    // Writes a C++ header declaring the SpriteID of every registered sprite and the MapID of every map, matching the archive
+    void write_sprite_ids(std::string const &filename) const;
+
+    // Writes a C++ source file holding the same tables as the archive as constant arrays (see EmbeddedAssets in Sprites.hpp)
+    void write_embedded_assets(std::string const &filename) const;
 
-    // Takes a given PPM P3 image, parses it and writes the resulting data to out (file name)
-    void parse_image(std::string const &filename, std::string const &out);
+    // Writes how much of the PPU's budget (tiles, palettes, sprite table entries) the registered assets use,
+    // with the statistics of every sprite, map, palette and parsed file, as text or as JSON
+    void write_report(std::ostream &output) const;
+    void write_report_json(std::ostream &output) const;
 
-    // Parse every image in a given directory
+    // Parse every image and atlas manifest in a given directory and write the result to parsing/assets.ppu,
+    // parsing/sprite_ids.hpp and parsing/embedded_assets.cpp. Images used by a manifest are not sprites of their own,
+    // and images named <name>.map.<extension> are background maps.
+    // Images are sliced in parallel, their palettes are packed together, then they are registered
+    // in the order of their path so the output does not depend on scheduling or on the directory order.
     void parse_directory(std::string const &filename);
 };
\ No newline at end of file
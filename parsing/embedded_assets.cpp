@@ -0,0 +1,327 @@
+// Generated by parsing/parse_ppm, do not edit.
+// The tables of parsing/assets.ppu as constant data, so the game can start without reading any file.
+#include "Sprites.hpp"
+
+#include <array>
+
+static constexpr std::array<PPU466::Tile, 19> Tiles = {
+    PPU466::Tile{{0x00, 0x00, 0x10, 0x00, 0x40, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00}},
+    PPU466::Tile{{0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00}},
+    PPU466::Tile{{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x20, 0x00, 0x40, 0x00, 0x00, 0x02, 0x00}},
+    PPU466::Tile{{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    PPU466::Tile{{0x0c, 0x08, 0x18, 0x70, 0xc0, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    PPU466::Tile{{0x00, 0x00, 0x00, 0x06, 0x03, 0x00, 0x00, 0x00}, {0x3e, 0x1c, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    PPU466::Tile{{0x00, 0x80, 0xf0, 0xf8, 0x7c, 0x3c, 0x0e, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    PPU466::Tile{{0x0e, 0x7f, 0xff, 0xe7, 0x82, 0x02, 0x06, 0x04}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    PPU466::Tile{{0x00, 0x00, 0x03, 0x07, 0x0f, 0x0e, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x26}},
+    PPU466::Tile{{0x00, 0x78, 0x7e, 0x7f, 0x3f, 0x3f, 0x61, 0x06}, {0xcf, 0x80, 0xbc, 0x42, 0xc0, 0xe4, 0x9e, 0x18}},
+    PPU466::Tile{{0x00, 0x7c, 0x7e, 0x3f, 0x3f, 0x3f, 0x61, 0x06}, {0xcf, 0xbc, 0xc2, 0x00, 0xe4, 0xc0, 0x9e, 0x18}},
+    PPU466::Tile{{0x00, 0x78, 0x7f, 0xff, 0x0f, 0x3f, 0x61, 0x06}, {0xcf, 0x80, 0x87, 0x08, 0xc0, 0xc5, 0x9e, 0x18}},
+    PPU466::Tile{{0x00, 0x78, 0xfe, 0xff, 0x33, 0xbf, 0x61, 0x06}, {0xcf, 0x80, 0xe0, 0x10, 0xc0, 0xe0, 0x9e, 0x18}},
+    PPU466::Tile{{0x00, 0x78, 0x7e, 0x3f, 0x7f, 0x3f, 0x65, 0x06}, {0xcf, 0x80, 0x80, 0x3c, 0xc2, 0xc0, 0xbe, 0x18}},
+    PPU466::Tile{{0xff, 0xf7, 0xff, 0xdf, 0xff, 0xff, 0xfd, 0xff}, {0x00, 0x08, 0x00, 0x20, 0x00, 0x00, 0x02, 0x00}},
+    PPU466::Tile{{0xfc, 0xfc, 0xfc, 0xf8, 0xf0, 0xa0, 0xe0, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00}},
+    PPU466::Tile{{0x7f, 0x7f, 0x7e, 0x6f, 0x3f, 0x3f, 0x3f, 0x00}, {0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00}},
+    PPU466::Tile{{0x00, 0xfc, 0xfe, 0xbe, 0xfe, 0xf6, 0xfe, 0xfe}, {0x00, 0x00, 0x00, 0x40, 0x00, 0x08, 0x00, 0x00}},
+    PPU466::Tile{{0x00, 0x03, 0x3f, 0x7f, 0x7f, 0x7f, 0x77, 0x7f}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00}},
+};
+
+static constexpr std::array<PPU466::Palette, 4> Palettes = {
+    PPU466::Palette{glm::u8vec4(0x00, 0x00, 0x00, 0xff), glm::u8vec4(0x1d, 0x1d, 0x1d, 0xff), glm::u8vec4(0x2f, 0x2f, 0x2f, 0xff), glm::u8vec4(0xff, 0xff, 0xff, 0xff)},
+    PPU466::Palette{glm::u8vec4(0x21, 0x6d, 0x27, 0xff), glm::u8vec4(0x4e, 0x00, 0x95, 0xff), glm::u8vec4(0x00, 0xff, 0xe3, 0xff), glm::u8vec4(0xff, 0x00, 0x00, 0x00)},
+    PPU466::Palette{glm::u8vec4(0xff, 0x00, 0xff, 0x00), glm::u8vec4(0x00, 0x00, 0x00, 0xff), glm::u8vec4(0x4e, 0x00, 0x95, 0xff), glm::u8vec4(0xff, 0x00, 0x00, 0x00)},
+    PPU466::Palette{glm::u8vec4(0xff, 0x00, 0xff, 0x00), glm::u8vec4(0x00, 0xad, 0x0e, 0xff), glm::u8vec4(0x00, 0xff, 0xe3, 0xff), glm::u8vec4(0xff, 0x00, 0x00, 0x00)},
+};
+
+static constexpr std::array<Sprites::Entry, 11> Entries = {
+    Sprites::Entry{0, 11, 0, 1}, // background1
+    Sprites::Entry{11, 11, 1, 1}, // background2
+    Sprites::Entry{22, 11, 2, 1}, // background3
+    Sprites::Entry{33, 6, 3, 6}, // flower
+    Sprites::Entry{39, 6, 9, 1}, // player
+    Sprites::Entry{45, 11, 10, 1}, // player_down
+    Sprites::Entry{56, 11, 11, 1}, // player_left
+    Sprites::Entry{67, 12, 12, 1}, // player_right
+    Sprites::Entry{79, 9, 13, 1}, // player_up
+    Sprites::Entry{88, 4, 14, 1}, // void
+    Sprites::Entry{92, 11, 15, 4}, // void_puddle
+};
+
+static constexpr std::array<Sprite::TileRef, 19> TileRefs = {
+    Sprite::TileRef{0, 1, 0, 0},
+    Sprite::TileRef{1, 1, 0, 0},
+    Sprite::TileRef{2, 1, 0, 0},
+    Sprite::TileRef{3, 2, 0, 1},
+    Sprite::TileRef{4, 3, 1, 1},
+    Sprite::TileRef{5, 3, 2, 1},
+    Sprite::TileRef{6, 3, 0, 0},
+    Sprite::TileRef{7, 3, 1, 0},
+    Sprite::TileRef{8, 3, 2, 0},
+    Sprite::TileRef{9, 0, 0, 0},
+    Sprite::TileRef{10, 0, 0, 0},
+    Sprite::TileRef{11, 0, 0, 0},
+    Sprite::TileRef{12, 0, 0, 0},
+    Sprite::TileRef{13, 0, 0, 0},
+    Sprite::TileRef{14, 2, 0, 0},
+    Sprite::TileRef{15, 2, 0, 1},
+    Sprite::TileRef{16, 2, 1, 1},
+    Sprite::TileRef{17, 2, 0, 0},
+    Sprite::TileRef{18, 2, 1, 0},
+};
+
+static constexpr std::array<Sprites::MapEntry, 1> MapEntries = {
+    Sprites::MapEntry{103, 5, 0, 64, 60}, // level
+};
+
+static constexpr std::array<uint16_t, 3840> MapTiles = {
+    257, 256, 258, 256, 256, 257, 256, 257, 256, 258, 256, 258, 258, 256, 258, 256,
+    258, 258, 258, 257, 256, 257, 257, 258, 257, 258, 257, 258, 257, 256, 256, 257,
+    258, 257, 256, 258, 258, 257, 257, 257, 258, 256, 258, 258, 256, 257, 257, 256,
+    257, 258, 258, 257, 258, 256, 257, 256, 257, 257, 256, 258, 256, 257, 258, 257,
+    256, 256, 257, 257, 257, 256, 257, 258, 257, 257, 257, 258, 258, 256, 256, 256,
+    258, 258, 258, 258, 257, 258, 256, 258, 256, 258, 258, 256, 258, 258, 258, 256,
+    256, 258, 256, 256, 257, 256, 258, 258, 258, 258, 257, 256, 257, 258, 258, 257,
+    257, 256, 256, 258, 258, 256, 256, 258, 256, 257, 258, 256, 256, 258, 258, 257,
+    258, 256, 258, 257, 257, 257, 257, 258, 256, 258, 257, 257, 257, 257, 258, 256,
+    258, 258, 258, 256, 257, 258, 257, 257, 258, 257, 257, 257, 257, 257, 257, 256,
+    258, 258, 257, 256, 258, 258, 256, 256, 257, 257, 258, 256, 256, 256, 258, 256,
+    257, 257, 256, 256, 258, 256, 257, 256, 256, 257, 258, 256, 257, 256, 258, 256,
+    258, 258, 258, 257, 257, 258, 256, 258, 258, 257, 258, 257, 257, 257, 258, 257,
+    257, 257, 256, 258, 257, 258, 257, 257, 258, 256, 257, 257, 256, 256, 256, 258,
+    257, 257, 258, 257, 258, 258, 257, 258, 258, 256, 256, 256, 257, 256, 256, 256,
+    258, 257, 258, 256, 257, 257, 256, 256, 257, 256, 257, 257, 257, 257, 256, 257,
+    256, 257, 257, 258, 258, 257, 256, 256, 256, 256, 258, 256, 256, 256, 258, 257,
+    257, 257, 257, 256, 258, 257, 258, 256, 257, 258, 256, 256, 256, 258, 257, 258,
+    258, 257, 257, 258, 256, 256, 258, 256, 257, 257, 256, 257, 257, 256, 257, 257,
+    257, 258, 258, 257, 258, 257, 256, 258, 257, 256, 258, 257, 258, 257, 257, 256,
+    256, 256, 257, 256, 258, 258, 256, 256, 256, 258, 258, 257, 256, 257, 257, 256,
+    256, 258, 257, 257, 257, 256, 257, 256, 256, 256, 256, 258, 256, 258, 257, 257,
+    257, 258, 256, 257, 258, 257, 256, 258, 256, 258, 256, 256, 258, 258, 257, 256,
+    257, 258, 257, 256, 256, 257, 257, 257, 256, 258, 258, 257, 257, 256, 258, 256,
+    258, 258, 257, 258, 258, 258, 257, 256, 257, 257, 258, 257, 257, 256, 258, 258,
+    258, 256, 258, 258, 258, 258, 258, 258, 257, 258, 258, 256, 257, 257, 256, 256,
+    256, 256, 258, 257, 257, 258, 257, 258, 258, 256, 256, 256, 256, 257, 258, 256,
+    258, 258, 257, 257, 258, 257, 256, 256, 258, 256, 257, 256, 256, 258, 257, 258,
+    257, 258, 257, 257, 257, 258, 256, 258, 258, 256, 258, 256, 257, 256, 257, 256,
+    257, 258, 258, 256, 258, 257, 257, 258, 256, 257, 257, 256, 258, 258, 257, 257,
+    258, 256, 256, 258, 256, 257, 258, 256, 258, 257, 257, 256, 256, 258, 257, 257,
+    258, 256, 257, 258, 257, 257, 257, 256, 258, 258, 256, 258, 258, 257, 258, 258,
+    256, 257, 258, 257, 258, 256, 257, 256, 256, 257, 258, 258, 256, 257, 256, 258,
+    257, 256, 258, 256, 257, 257, 257, 256, 256, 257, 258, 258, 258, 256, 257, 257,
+    256, 256, 257, 256, 258, 256, 258, 257, 256, 256, 257, 258, 256, 257, 257, 256,
+    257, 256, 256, 256, 257, 257, 258, 258, 256, 257, 258, 257, 257, 256, 258, 257,
+    258, 258, 257, 258, 258, 257, 257, 257, 257, 257, 257, 258, 258, 256, 257, 256,
+    257, 258, 256, 257, 258, 258, 256, 257, 257, 257, 258, 258, 256, 257, 258, 258,
+    258, 258, 256, 257, 256, 256, 257, 258, 257, 256, 256, 257, 258, 257, 256, 256,
+    257, 257, 257, 256, 257, 258, 257, 257, 258, 258, 257, 257, 257, 258, 258, 258,
+    256, 257, 258, 257, 256, 258, 257, 257, 257, 257, 258, 256, 258, 257, 258, 257,
+    257, 257, 256, 258, 256, 256, 256, 258, 257, 256, 256, 258, 258, 258, 258, 256,
+    257, 257, 257, 257, 257, 256, 256, 256, 257, 258, 257, 256, 256, 258, 258, 258,
+    257, 258, 256, 257, 258, 256, 256, 256, 256, 257, 256, 257, 258, 258, 257, 257,
+    258, 256, 258, 256, 257, 258, 258, 257, 257, 256, 256, 256, 257, 258, 258, 257,
+    257, 258, 257, 257, 256, 257, 258, 256, 257, 256, 258, 258, 257, 258, 258, 258,
+    258, 256, 257, 257, 258, 256, 257, 258, 257, 256, 257, 258, 258, 256, 258, 258,
+    258, 257, 257, 257, 258, 258, 256, 257, 258, 257, 257, 257, 257, 256, 258, 257,
+    257, 257, 257, 257, 258, 256, 257, 258, 256, 256, 256, 257, 257, 258, 257, 257,
+    256, 258, 257, 256, 256, 256, 257, 257, 256, 256, 256, 256, 258, 256, 258, 258,
+    258, 256, 258, 256, 257, 256, 257, 257, 257, 258, 256, 258, 256, 258, 256, 258,
+    256, 256, 256, 258, 258, 258, 258, 258, 257, 258, 258, 258, 258, 257, 256, 258,
+    257, 256, 256, 257, 258, 258, 258, 256, 256, 256, 256, 257, 257, 257, 258, 257,
+    256, 258, 256, 258, 258, 257, 257, 258, 258, 256, 256, 257, 258, 258, 258, 258,
+    258, 256, 256, 258, 256, 256, 258, 258, 257, 256, 256, 258, 258, 257, 256, 257,
+    256, 258, 256, 256, 257, 256, 257, 258, 258, 258, 257, 257, 256, 257, 257, 256,
+    256, 257, 257, 258, 257, 257, 258, 256, 256, 258, 256, 258, 258, 257, 257, 257,
+    258, 256, 257, 258, 256, 258, 258, 257, 257, 256, 258, 257, 256, 258, 257, 257,
+    256, 258, 258, 258, 257, 257, 257, 258, 257, 257, 258, 256, 257, 257, 258, 258,
+    258, 258, 258, 256, 257, 258, 257, 257, 257, 256, 258, 256, 257, 256, 258, 256,
+    258, 258, 257, 257, 258, 258, 256, 257, 257, 258, 258, 257, 256, 257, 258, 257,
+    258, 257, 257, 256, 256, 257, 258, 257, 258, 257, 257, 256, 258, 258, 256, 257,
+    258, 256, 257, 257, 256, 257, 256, 257, 256, 258, 258, 256, 256, 257, 258, 257,
+    256, 257, 257, 256, 257, 257, 256, 257, 258, 256, 258, 258, 256, 258, 257, 257,
+    256, 258, 257, 256, 256, 258, 257, 257, 257, 257, 257, 256, 258, 257, 256, 258,
+    256, 258, 256, 257, 257, 257, 256, 256, 258, 256, 257, 257, 258, 258, 258, 256,
+    256, 256, 258, 256, 257, 257, 256, 256, 256, 256, 258, 257, 258, 257, 257, 258,
+    256, 256, 257, 258, 257, 256, 256, 258, 256, 258, 258, 258, 256, 256, 257, 256,
+    256, 256, 257, 258, 256, 257, 258, 258, 257, 258, 256, 256, 256, 256, 257, 256,
+    258, 256, 258, 257, 258, 257, 258, 258, 256, 256, 258, 258, 258, 258, 257, 258,
+    257, 257, 258, 257, 257, 256, 256, 258, 256, 257, 258, 258, 257, 257, 257, 256,
+    256, 256, 258, 256, 257, 257, 258, 256, 256, 258, 256, 257, 256, 257, 257, 258,
+    258, 258, 258, 258, 258, 256, 257, 258, 257, 256, 258, 257, 258, 256, 257, 258,
+    258, 256, 256, 258, 257, 256, 256, 258, 256, 256, 258, 256, 258, 258, 256, 257,
+    257, 257, 256, 257, 256, 257, 257, 258, 258, 257, 258, 256, 257, 257, 257, 257,
+    256, 258, 256, 258, 256, 257, 256, 257, 257, 257, 256, 256, 258, 257, 256, 257,
+    258, 257, 257, 257, 257, 258, 256, 258, 256, 257, 258, 258, 257, 258, 257, 258,
+    258, 258, 256, 258, 256, 257, 256, 258, 256, 256, 256, 258, 257, 256, 256, 256,
+    258, 258, 256, 257, 256, 258, 257, 256, 258, 256, 256, 257, 258, 258, 256, 256,
+    258, 256, 257, 256, 256, 258, 258, 258, 257, 256, 256, 257, 256, 258, 256, 256,
+    258, 257, 258, 257, 258, 256, 256, 258, 256, 256, 256, 256, 256, 258, 258, 256,
+    257, 257, 257, 257, 258, 257, 256, 256, 256, 256, 257, 257, 257, 257, 256, 257,
+    257, 258, 258, 256, 256, 257, 258, 257, 256, 258, 256, 257, 258, 258, 256, 256,
+    256, 258, 258, 258, 257, 257, 257, 256, 258, 256, 256, 256, 257, 258, 257, 258,
+    258, 257, 258, 257, 257, 256, 257, 257, 257, 256, 258, 257, 256, 256, 256, 258,
+    256, 256, 256, 256, 257, 257, 257, 256, 257, 256, 257, 256, 258, 257, 256, 257,
+    258, 257, 256, 258, 257, 256, 258, 257, 258, 257, 257, 257, 258, 256, 256, 256,
+    256, 257, 258, 257, 257, 258, 256, 258, 257, 256, 258, 258, 257, 257, 258, 256,
+    258, 256, 256, 258, 256, 258, 257, 256, 256, 258, 257, 256, 257, 257, 258, 257,
+    258, 258, 258, 256, 258, 258, 256, 256, 257, 256, 258, 258, 256, 257, 258, 257,
+    257, 256, 257, 258, 256, 257, 256, 257, 256, 257, 258, 257, 258, 258, 256, 258,
+    258, 256, 256, 257, 256, 257, 256, 256, 258, 258, 257, 256, 257, 258, 257, 256,
+    257, 256, 256, 257, 256, 258, 257, 257, 257, 257, 258, 258, 256, 257, 257, 256,
+    256, 258, 256, 257, 257, 256, 258, 257, 256, 257, 256, 256, 257, 258, 258, 258,
+    258, 256, 258, 256, 257, 256, 258, 258, 256, 257, 258, 257, 257, 256, 256, 257,
+    258, 257, 256, 257, 258, 256, 257, 258, 256, 256, 257, 256, 258, 258, 258, 256,
+    256, 256, 258, 258, 256, 258, 258, 256, 257, 257, 258, 258, 256, 258, 256, 257,
+    258, 257, 257, 256, 258, 257, 256, 257, 256, 257, 258, 256, 256, 258, 257, 256,
+    256, 256, 258, 258, 257, 258, 257, 257, 258, 257, 257, 257, 257, 257, 256, 258,
+    257, 258, 256, 256, 258, 257, 258, 257, 256, 258, 258, 258, 256, 256, 258, 257,
+    257, 258, 257, 258, 258, 256, 256, 258, 256, 256, 258, 256, 256, 258, 256, 257,
+    257, 258, 257, 257, 257, 258, 258, 256, 257, 257, 256, 258, 257, 258, 257, 257,
+    258, 258, 256, 258, 258, 258, 256, 258, 257, 257, 256, 256, 257, 256, 257, 257,
+    258, 257, 257, 256, 257, 256, 256, 258, 256, 257, 256, 257, 257, 258, 257, 258,
+    256, 256, 258, 258, 258, 258, 257, 258, 257, 258, 257, 256, 257, 256, 257, 256,
+    257, 258, 256, 258, 258, 258, 257, 257, 257, 256, 258, 258, 258, 258, 257, 258,
+    257, 257, 257, 256, 257, 256, 256, 256, 256, 258, 258, 258, 257, 258, 256, 257,
+    258, 256, 258, 257, 257, 256, 257, 257, 257, 257, 258, 257, 256, 257, 257, 258,
+    257, 257, 256, 257, 256, 256, 256, 257, 258, 258, 256, 257, 258, 256, 256, 258,
+    256, 257, 258, 258, 256, 257, 257, 256, 258, 256, 257, 256, 258, 257, 257, 256,
+    257, 258, 257, 258, 256, 256, 258, 258, 258, 258, 258, 257, 258, 257, 258, 256,
+    258, 258, 257, 258, 258, 257, 256, 256, 258, 257, 257, 256, 257, 257, 256, 256,
+    256, 256, 258, 257, 256, 256, 256, 257, 256, 256, 256, 258, 258, 257, 257, 258,
+    258, 258, 256, 258, 257, 258, 256, 258, 258, 257, 256, 257, 258, 256, 258, 258,
+    258, 256, 258, 258, 256, 258, 256, 258, 257, 256, 257, 256, 256, 257, 257, 256,
+    256, 256, 257, 257, 256, 256, 258, 257, 256, 258, 256, 256, 258, 257, 258, 257,
+    258, 258, 257, 256, 256, 258, 258, 256, 258, 256, 258, 257, 258, 258, 258, 257,
+    257, 256, 256, 257, 258, 256, 257, 258, 258, 258, 257, 258, 256, 257, 257, 257,
+    258, 258, 257, 256, 256, 256, 256, 256, 258, 257, 257, 257, 258, 256, 257, 257,
+    258, 258, 257, 256, 258, 257, 257, 257, 257, 256, 256, 256, 258, 257, 257, 257,
+    257, 257, 256, 258, 258, 256, 258, 256, 258, 257, 258, 257, 258, 256, 257, 257,
+    257, 257, 256, 258, 258, 256, 256, 257, 258, 257, 258, 257, 256, 256, 258, 256,
+    258, 258, 257, 258, 258, 256, 257, 257, 258, 256, 258, 256, 258, 256, 256, 258,
+    257, 257, 256, 257, 257, 257, 258, 258, 258, 258, 256, 258, 258, 256, 257, 258,
+    257, 257, 258, 257, 256, 256, 257, 257, 256, 256, 257, 257, 258, 256, 257, 258,
+    256, 257, 257, 258, 257, 256, 257, 258, 258, 258, 256, 258, 257, 258, 256, 257,
+    258, 257, 257, 256, 256, 256, 256, 256, 256, 258, 256, 257, 258, 258, 257, 257,
+    256, 257, 257, 256, 256, 257, 257, 257, 258, 258, 256, 257, 258, 258, 257, 258,
+    258, 256, 258, 257, 256, 257, 257, 256, 258, 257, 257, 256, 256, 256, 257, 258,
+    256, 258, 257, 258, 256, 258, 257, 258, 256, 256, 258, 257, 256, 257, 258, 257,
+    257, 257, 257, 257, 256, 258, 257, 258, 257, 257, 256, 257, 257, 258, 257, 256,
+    258, 257, 258, 256, 257, 257, 256, 256, 256, 256, 257, 256, 258, 258, 256, 257,
+    258, 258, 256, 257, 257, 258, 256, 257, 258, 257, 257, 258, 256, 258, 258, 257,
+    256, 256, 258, 258, 258, 258, 257, 257, 257, 257, 257, 257, 256, 258, 257, 256,
+    256, 256, 257, 257, 257, 258, 258, 256, 257, 257, 258, 258, 257, 258, 256, 256,
+    257, 257, 258, 256, 257, 257, 257, 257, 256, 256, 258, 256, 256, 256, 256, 258,
+    258, 256, 256, 257, 256, 258, 256, 256, 256, 258, 258, 256, 256, 257, 258, 257,
+    257, 256, 257, 256, 258, 256, 256, 258, 256, 256, 257, 257, 256, 257, 257, 258,
+    257, 258, 258, 257, 256, 256, 257, 258, 258, 256, 257, 258, 257, 257, 258, 257,
+    256, 258, 258, 257, 256, 258, 258, 257, 257, 257, 257, 256, 256, 256, 258, 257,
+    256, 256, 258, 257, 257, 256, 256, 256, 257, 256, 258, 258, 257, 258, 258, 256,
+    256, 257, 258, 256, 258, 257, 257, 256, 257, 258, 258, 258, 256, 258, 257, 257,
+    256, 256, 256, 258, 256, 258, 256, 257, 257, 257, 257, 257, 257, 258, 258, 257,
+    256, 257, 258, 256, 258, 256, 256, 257, 257, 258, 257, 256, 258, 258, 258, 258,
+    256, 258, 256, 258, 256, 258, 256, 257, 256, 258, 256, 257, 257, 256, 256, 257,
+    257, 258, 257, 258, 256, 256, 258, 257, 256, 258, 256, 256, 258, 257, 257, 258,
+    257, 256, 258, 258, 257, 258, 258, 258, 257, 258, 258, 256, 258, 257, 257, 256,
+    256, 258, 256, 256, 258, 257, 258, 256, 257, 257, 257, 256, 257, 257, 258, 256,
+    256, 256, 258, 258, 258, 256, 256, 257, 258, 257, 257, 257, 258, 258, 258, 257,
+    258, 258, 256, 258, 256, 256, 257, 257, 257, 257, 257, 257, 256, 256, 258, 258,
+    257, 257, 257, 256, 258, 258, 257, 257, 258, 258, 256, 256, 257, 256, 258, 257,
+    257, 258, 257, 257, 258, 257, 257, 258, 256, 257, 258, 256, 256, 258, 256, 256,
+    257, 257, 257, 257, 258, 258, 258, 258, 256, 258, 258, 256, 258, 258, 258, 257,
+    257, 257, 258, 256, 257, 257, 258, 256, 257, 258, 256, 256, 257, 256, 256, 258,
+    256, 256, 256, 256, 258, 256, 258, 257, 258, 256, 258, 258, 257, 256, 257, 257,
+    258, 257, 258, 258, 257, 258, 256, 257, 257, 258, 257, 256, 258, 257, 257, 257,
+    257, 256, 258, 258, 257, 258, 258, 257, 257, 257, 256, 258, 257, 257, 258, 257,
+    257, 258, 257, 256, 257, 257, 257, 256, 258, 258, 258, 257, 256, 257, 257, 257,
+    257, 256, 257, 258, 256, 257, 256, 256, 256, 258, 256, 258, 256, 256, 256, 257,
+    257, 258, 256, 256, 258, 258, 258, 257, 258, 256, 258, 257, 258, 258, 258, 256,
+    256, 257, 257, 258, 256, 258, 258, 257, 257, 258, 256, 258, 256, 256, 257, 256,
+    256, 257, 258, 256, 257, 257, 257, 256, 258, 256, 257, 256, 258, 256, 258, 258,
+    258, 257, 258, 258, 256, 256, 257, 257, 257, 257, 258, 257, 256, 258, 258, 258,
+    258, 258, 258, 257, 257, 256, 258, 256, 258, 258, 257, 256, 258, 257, 258, 257,
+    258, 256, 258, 257, 256, 258, 258, 258, 257, 257, 258, 257, 258, 258, 256, 256,
+    256, 257, 258, 256, 256, 257, 256, 256, 256, 256, 258, 256, 257, 256, 256, 256,
+    256, 258, 256, 256, 257, 256, 258, 256, 258, 258, 257, 256, 258, 257, 256, 256,
+    257, 256, 257, 256, 257, 258, 257, 257, 258, 256, 256, 257, 257, 257, 256, 256,
+    258, 257, 257, 258, 257, 256, 258, 256, 256, 256, 256, 256, 257, 257, 256, 256,
+    256, 258, 257, 258, 257, 256, 258, 256, 257, 256, 257, 258, 257, 258, 258, 257,
+    258, 256, 258, 256, 257, 258, 256, 258, 258, 257, 257, 256, 256, 258, 257, 257,
+    258, 257, 257, 256, 256, 256, 256, 258, 257, 256, 257, 258, 258, 256, 257, 256,
+    256, 258, 258, 256, 258, 258, 256, 258, 258, 257, 258, 257, 256, 258, 257, 256,
+    257, 256, 257, 258, 256, 257, 258, 257, 256, 256, 257, 258, 257, 256, 257, 257,
+    258, 258, 257, 256, 257, 256, 257, 256, 257, 257, 257, 258, 258, 258, 257, 256,
+    256, 257, 257, 258, 257, 256, 256, 257, 256, 257, 257, 258, 256, 258, 256, 257,
+    257, 258, 257, 257, 258, 258, 258, 257, 257, 257, 256, 258, 257, 256, 257, 256,
+    257, 258, 256, 257, 256, 256, 258, 257, 258, 258, 258, 257, 258, 256, 258, 257,
+    258, 256, 258, 257, 258, 258, 258, 257, 256, 256, 256, 256, 258, 258, 257, 256,
+    256, 258, 257, 258, 257, 258, 258, 258, 256, 257, 256, 256, 258, 258, 258, 258,
+    257, 258, 257, 257, 256, 258, 257, 258, 256, 256, 257, 257, 256, 256, 257, 257,
+    258, 258, 258, 258, 256, 256, 257, 256, 256, 256, 258, 257, 258, 258, 258, 258,
+    258, 257, 256, 258, 257, 256, 258, 258, 258, 257, 258, 258, 258, 258, 257, 256,
+    258, 256, 257, 258, 256, 257, 257, 258, 256, 258, 257, 257, 257, 258, 256, 258,
+    256, 256, 258, 257, 257, 257, 258, 258, 256, 257, 258, 256, 256, 256, 256, 256,
+    257, 257, 257, 258, 256, 257, 257, 256, 257, 257, 258, 258, 256, 258, 257, 256,
+    256, 258, 257, 257, 258, 258, 257, 257, 256, 258, 258, 258, 258, 257, 256, 257,
+    257, 256, 258, 256, 258, 256, 256, 258, 257, 258, 258, 256, 257, 258, 256, 256,
+    257, 258, 257, 256, 256, 258, 258, 257, 256, 257, 257, 257, 257, 256, 257, 256,
+    258, 256, 257, 256, 257, 257, 258, 258, 258, 256, 258, 257, 257, 257, 256, 256,
+    258, 257, 256, 257, 258, 257, 257, 258, 257, 258, 256, 257, 258, 257, 256, 258,
+    256, 256, 256, 256, 258, 258, 256, 256, 258, 256, 258, 256, 258, 258, 258, 256,
+    258, 256, 257, 257, 257, 257, 256, 257, 258, 256, 257, 258, 256, 256, 258, 258,
+    257, 257, 257, 257, 257, 257, 257, 258, 256, 257, 258, 257, 257, 258, 258, 258,
+    257, 258, 256, 258, 258, 256, 256, 256, 257, 256, 258, 257, 257, 256, 257, 258,
+    256, 257, 257, 256, 258, 257, 256, 256, 258, 256, 256, 257, 256, 256, 257, 256,
+    258, 257, 256, 256, 257, 256, 258, 258, 256, 258, 257, 258, 258, 257, 257, 257,
+    256, 258, 257, 257, 256, 256, 256, 258, 256, 258, 257, 258, 256, 257, 256, 256,
+    257, 256, 256, 256, 256, 257, 258, 258, 258, 256, 258, 256, 258, 257, 257, 257,
+    256, 256, 258, 257, 257, 258, 256, 257, 256, 258, 256, 256, 256, 258, 257, 258,
+    257, 257, 257, 258, 257, 257, 257, 257, 258, 258, 257, 256, 256, 256, 258, 257,
+    257, 257, 258, 256, 257, 258, 257, 258, 258, 258, 258, 258, 258, 256, 258, 256,
+    256, 256, 256, 256, 257, 257, 258, 258, 256, 258, 257, 257, 257, 257, 256, 256,
+    257, 258, 256, 258, 257, 257, 257, 258, 257, 258, 258, 258, 256, 258, 257, 256,
+    256, 256, 257, 258, 257, 257, 256, 258, 256, 257, 256, 256, 256, 256, 256, 257,
+    256, 257, 256, 256, 256, 258, 256, 258, 256, 256, 258, 258, 257, 258, 256, 258,
+    257, 256, 257, 257, 256, 257, 256, 258, 257, 257, 257, 256, 256, 257, 258, 256,
+    258, 256, 256, 256, 256, 257, 258, 257, 257, 257, 258, 257, 256, 256, 257, 258,
+    256, 257, 258, 258, 257, 258, 256, 257, 256, 256, 257, 257, 256, 256, 258, 256,
+    257, 257, 256, 257, 257, 257, 258, 257, 257, 256, 258, 256, 258, 256, 258, 257,
+    256, 258, 258, 257, 258, 258, 256, 257, 258, 257, 256, 256, 257, 256, 257, 256,
+    258, 257, 256, 257, 258, 257, 256, 257, 257, 257, 256, 257, 257, 258, 258, 258,
+    256, 256, 258, 256, 258, 257, 258, 256, 256, 256, 258, 256, 257, 257, 256, 257,
+    256, 258, 258, 257, 256, 257, 258, 256, 256, 258, 258, 258, 257, 256, 258, 256,
+    258, 257, 257, 258, 258, 258, 257, 256, 258, 257, 256, 256, 256, 256, 257, 256,
+    258, 257, 256, 258, 257, 258, 258, 257, 258, 258, 257, 257, 257, 257, 256, 258,
+    258, 257, 256, 257, 257, 258, 257, 258, 258, 256, 257, 258, 258, 256, 256, 257,
+    257, 258, 256, 257, 257, 258, 258, 257, 258, 257, 256, 256, 258, 258, 257, 257,
+    256, 256, 257, 257, 258, 257, 257, 258, 258, 257, 256, 257, 258, 257, 257, 258,
+    257, 257, 257, 257, 257, 256, 256, 256, 258, 256, 257, 257, 258, 257, 258, 258,
+    257, 258, 257, 256, 256, 257, 257, 257, 258, 256, 258, 258, 256, 256, 258, 257,
+    256, 256, 256, 256, 256, 256, 257, 258, 256, 256, 258, 257, 258, 258, 258, 258,
+    258, 258, 256, 258, 258, 256, 257, 257, 258, 256, 257, 257, 256, 256, 257, 256,
+    258, 258, 256, 257, 256, 256, 257, 258, 256, 257, 258, 257, 257, 257, 257, 257,
+    258, 256, 256, 256, 256, 257, 257, 256, 257, 258, 258, 258, 257, 256, 257, 257,
+    258, 256, 256, 256, 256, 256, 256, 258, 258, 256, 257, 257, 258, 256, 257, 258,
+    257, 258, 257, 256, 258, 256, 256, 258, 258, 256, 257, 258, 256, 257, 257, 257,
+    256, 256, 257, 258, 257, 258, 256, 258, 258, 257, 258, 256, 258, 256, 256, 258,
+    256, 257, 257, 258, 256, 257, 257, 258, 256, 258, 257, 258, 258, 256, 257, 256,
+    258, 258, 258, 256, 256, 258, 258, 257, 257, 258, 257, 257, 256, 256, 258, 256,
+    258, 257, 257, 256, 256, 258, 256, 258, 256, 257, 257, 257, 257, 258, 256, 256,
+    256, 256, 257, 257, 258, 256, 258, 256, 256, 256, 256, 256, 257, 257, 258, 257,
+    257, 257, 258, 258, 257, 257, 258, 258, 258, 256, 258, 257, 258, 258, 258, 258,
+    257, 257, 257, 257, 257, 258, 257, 257, 258, 258, 256, 258, 256, 256, 258, 258,
+    258, 258, 258, 256, 257, 257, 257, 258, 258, 256, 256, 256, 257, 258, 256, 256,
+    258, 256, 256, 258, 258, 257, 256, 257, 256, 257, 258, 258, 258, 257, 257, 257,
+    256, 256, 257, 256, 256, 256, 256, 258, 257, 258, 257, 256, 257, 257, 257, 256,
+    257, 257, 257, 257, 256, 257, 256, 258, 258, 256, 256, 258, 256, 256, 257, 257,
+    257, 258, 258, 258, 256, 258, 256, 257, 258, 257, 256, 256, 256, 257, 258, 258,
+    256, 258, 257, 258, 257, 256, 256, 257, 258, 258, 257, 258, 257, 256, 256, 257,
+};
+
+static constexpr char Names[] = "background1background2background3flowerplayerplayer_downplayer_leftplayer_rightplayer_upvoidvoid_puddlelevel";
+
+std::span<PPU466::Tile const> const EmbeddedAssets::tile_table = Tiles;
+std::span<PPU466::Palette const> const EmbeddedAssets::palette_table = Palettes;
+std::span<Sprites::Entry const> const EmbeddedAssets::entries = Entries;
+std::span<Sprite::TileRef const> const EmbeddedAssets::tile_refs = TileRefs;
+std::span<char const> const EmbeddedAssets::names = std::span<char const>(Names, sizeof(Names) - 1);
+std::span<Sprites::MapEntry const> const EmbeddedAssets::map_entries = MapEntries;
+std::span<uint16_t const> const EmbeddedAssets::map_tiles = MapTiles;
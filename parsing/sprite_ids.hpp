@@ -0,0 +1,51 @@
+// Generated by parsing/parse_ppm, do not edit.
+// One ID per sprite and per map of parsing/assets.ppu, in the order of its tables of contents (sorted by name).
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+enum class SpriteID : uint16_t
+{
+    background1 = 0,
+    background2 = 1,
+    background3 = 2,
+    flower = 3,
+    player = 4,
+    player_down = 5,
+    player_left = 6,
+    player_right = 7,
+    player_up = 8,
+    void_ = 9,
+    void_puddle = 10,
+};
+
+constexpr uint16_t SpriteCount = 11;
+
+// Names of the sprites, indexed by SpriteID
+constexpr std::array<std::string_view, SpriteCount> SpriteNames = {
+    "background1",
+    "background2",
+    "background3",
+    "flower",
+    "player",
+    "player_down",
+    "player_left",
+    "player_right",
+    "player_up",
+    "void",
+    "void_puddle",
+};
+
+enum class MapID : uint16_t
+{
+    level = 0,
+};
+
+constexpr uint16_t MapCount = 1;
+
+// Names of the maps, indexed by MapID
+constexpr std::array<std::string_view, MapCount> MapNames = {
+    "level",
+};
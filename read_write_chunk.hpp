@@ -2,14 +2,83 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <span>
+#include <cstring>
+#include <cstdint>
 #include <stdexcept>
 #include <cassert>
+#include <bit>
+#include <type_traits>
+
+#include <zlib.h>
 
 //helper function that reads an array of structures preceded by a simple header:
 //Expected format:
 // |ma|gi|c.|..| <-- four byte "magic number"
 // |sz|sz|sz|sz| <-- four byte (native endian) size
 // |TT...TT| * (sz/sizeof(TT)) <-- enough T structures to make up sz bytes
+//
+//Chunks written by write_chunk_compressed set the top bit of the size instead:
+// |ma|gi|c.|..| <-- four byte "magic number"
+// |sz|sz|sz|sz| <-- four byte (native endian) size of what follows, ORed with CompressedChunkFlag
+// |us|us|us|us| <-- four byte (native endian) size of the uncompressed data
+// |ZZ...ZZ| <-- zlib stream holding (us/sizeof(TT)) T structures, then zeros up to a multiple of 8 bytes
+//read_chunk into a vector accepts both kinds of chunks.
+
+constexpr uint32_t CompressedChunkFlag = 0x80000000;
+
+//streaming zlib decompression of a chunk's payload, shared by the readers below:
+struct ChunkInflater {
+	//decompresses into 'size' bytes at 'out':
+	ChunkInflater(void *out, size_t size) {
+		if (inflateInit(&stream) != Z_OK) {
+			throw std::runtime_error("Failed to initialize chunk decompression");
+		}
+		//zlib refuses a null output even when there is nothing to write:
+		stream.next_out = out ? reinterpret_cast< Bytef * >(out) : &empty;
+		stream.avail_out = uInt(size);
+	}
+	~ChunkInflater() {
+		inflateEnd(&stream);
+	}
+	ChunkInflater(ChunkInflater const &) = delete;
+	ChunkInflater &operator=(ChunkInflater const &) = delete;
+
+	//decompresses the next piece of the zlib stream:
+	void feed(uint8_t const *data, size_t size) {
+		stream.next_in = const_cast< Bytef * >(data);
+		stream.avail_in = uInt(size);
+		while (stream.avail_in > 0 && !ended) {
+			int result = inflate(&stream, Z_NO_FLUSH);
+			if (result == Z_STREAM_END) {
+				ended = true;
+			} else if (result != Z_OK) {
+				throw std::runtime_error("Failed to decompress chunk data.");
+			}
+		}
+	}
+	//checks that the stream ended exactly when the output was filled:
+	void finish() const {
+		if (!ended || stream.avail_out != 0) {
+			throw std::runtime_error("Compressed chunk data does not match its size.");
+		}
+	}
+
+	//checks the uncompressed size read from a chunk header before anything is allocated for it,
+	// so a corrupt header can't ask for gigabytes (deflate never shrinks data by more than 1032:1):
+	static void check_size(uint32_t compressed_size, uint32_t size) {
+		constexpr uint64_t MaxRatio = 1032;
+		if (size > uint64_t(compressed_size) * MaxRatio) {
+			throw std::runtime_error("Compressed chunk claims " + std::to_string(size) + " bytes of data, more than its " + std::to_string(compressed_size) + " compressed bytes can hold.");
+		}
+	}
+
+	z_stream stream = {};
+	bool ended = false;
+	Bytef empty = 0;
+};
 
 template< typename T >
 void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *to_) {
@@ -30,6 +99,33 @@ void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *
 		throw std::runtime_error("Unexpected magic number in chunk");
 	}
 
+	if (header.size & CompressedChunkFlag) {
+		uint32_t compressed_size = header.size & ~CompressedChunkFlag;
+		uint32_t size = 0;
+		if (compressed_size < 4 || !from.read(reinterpret_cast< char * >(&size), sizeof(size))) {
+			throw std::runtime_error("Failed to read chunk header");
+		}
+		if (size % sizeof(T) != 0) {
+			throw std::runtime_error("Size of chunk not divisible by element size");
+		}
+		ChunkInflater::check_size(compressed_size - 4, size);
+		to.resize(size / sizeof(T));
+
+		//decompress block by block, so the compressed data is never held in memory all at once:
+		ChunkInflater inflater(to.data(), size);
+		char block[16384];
+		for (uint32_t left = compressed_size - 4; left > 0; ) {
+			uint32_t count = std::min< uint32_t >(left, sizeof(block));
+			if (!from.read(block, count)) {
+				throw std::runtime_error("Failed to read chunk data.");
+			}
+			inflater.feed(reinterpret_cast< uint8_t const * >(block), count);
+			left -= count;
+		}
+		inflater.finish();
+		return;
+	}
+
 	if (header.size % sizeof(T) != 0) {
 		throw std::runtime_error("Size of chunk not divisible by element size");
 	}
@@ -40,6 +136,90 @@ void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *
 	}
 }
 
+//zero-copy version of read_chunk for chunks already in memory (e.g., a mapped file or an embedded blob):
+// reads the chunk at the start of 'from', points 'to' at its payload (nothing is copied),
+// and advances 'from' past the chunk, so successive calls walk through consecutive chunks.
+//NOTE: 'to' is only valid for as long as the memory behind 'from' is
+//NOTE: throws if the chunk is truncated, compressed, or its payload is not aligned for T
+template< typename T >
+void read_chunk(std::span< uint8_t const > &from, std::string const &magic, std::span< T const > *to_) {
+	assert(magic.size() == 4);
+	assert(to_);
+	auto &to = *to_;
+
+	if (from.size() < 8) {
+		throw std::runtime_error("Failed to read chunk header");
+	}
+	if (std::memcmp(from.data(), magic.data(), 4) != 0) {
+		throw std::runtime_error("Unexpected magic number in chunk");
+	}
+	uint32_t size = 0;
+	std::memcpy(&size, from.data() + 4, 4);
+
+	if (size & CompressedChunkFlag) {
+		throw std::runtime_error("Chunk is compressed and can't be read in place");
+	}
+	if (size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	if (from.size() - 8 < size) {
+		throw std::runtime_error("Failed to read chunk data.");
+	}
+	uint8_t const *payload = from.data() + 8;
+	if (reinterpret_cast< uintptr_t >(payload) % alignof(T) != 0) {
+		throw std::runtime_error("Chunk data is not aligned for its element type");
+	}
+
+	to = std::span< T const >(reinterpret_cast< T const * >(payload), size / sizeof(T));
+	from = from.subspan(8 + size);
+}
+
+//version of read_chunk for chunks already in memory that copies (or decompresses) the payload into a vector:
+// like the span version above, 'from' is advanced past the chunk.
+template< typename T >
+void read_chunk(std::span< uint8_t const > &from, std::string const &magic, std::vector< T > *to_) {
+	assert(magic.size() == 4);
+	assert(to_);
+	auto &to = *to_;
+
+	if (from.size() < 8) {
+		throw std::runtime_error("Failed to read chunk header");
+	}
+	if (std::memcmp(from.data(), magic.data(), 4) != 0) {
+		throw std::runtime_error("Unexpected magic number in chunk");
+	}
+	uint32_t size = 0;
+	std::memcpy(&size, from.data() + 4, 4);
+
+	if (!(size & CompressedChunkFlag)) {
+		std::span< uint8_t const > bytes;
+		read_chunk(from, magic, &bytes);
+		if (bytes.size() % sizeof(T) != 0) {
+			throw std::runtime_error("Size of chunk not divisible by element size");
+		}
+		to.resize(bytes.size() / sizeof(T));
+		if (!bytes.empty()) std::memcpy(to.data(), bytes.data(), bytes.size());
+		return;
+	}
+
+	uint32_t compressed_size = size & ~CompressedChunkFlag;
+	if (compressed_size < 4 || from.size() - 8 < compressed_size) {
+		throw std::runtime_error("Failed to read chunk data.");
+	}
+	std::memcpy(&size, from.data() + 8, 4);
+	if (size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	ChunkInflater::check_size(compressed_size - 4, size);
+	to.resize(size / sizeof(T));
+
+	ChunkInflater inflater(to.data(), size);
+	inflater.feed(from.data() + 12, compressed_size - 4);
+	inflater.finish();
+
+	from = from.subspan(8 + compressed_size);
+}
+
 
 //helper function to write a chunk of data in the same format as read_chunk:
 template< typename T >
@@ -63,3 +243,222 @@ void write_chunk(std::string const &magic, std::vector< T > const &from, std::os
 	to.write(reinterpret_cast< const char * >(&header), sizeof(header));
 	to.write(reinterpret_cast< const char * >(from.data()), from.size() * sizeof(T));
 }
+
+//helper function to write a zlib-compressed chunk, readable by read_chunk into a vector:
+// the data is compressed block by block straight into the stream, then the size in the header is filled in.
+//NOTE: 'to' must be seekable (e.g., a std::ofstream)
+template< typename T >
+void write_chunk_compressed(std::string const &magic, std::vector< T > const &from, std::ostream *to_, int level = Z_DEFAULT_COMPRESSION) {
+	assert(magic.size() == 4);
+	assert(to_);
+	auto &to = *to_;
+
+	struct ChunkHeader {
+		char magic[4] = {'\0', '\0', '\0', '\0'};
+		uint32_t size = 0;
+		uint32_t uncompressed_size = 0;
+	};
+	static_assert(sizeof(ChunkHeader) == 12, "header is packed");
+	ChunkHeader header;
+	header.magic[0] = magic[0];
+	header.magic[1] = magic[1];
+	header.magic[2] = magic[2];
+	header.magic[3] = magic[3];
+	header.uncompressed_size = uint32_t(from.size() * sizeof(T));
+
+	std::streampos start = to.tellp();
+	to.write(reinterpret_cast< const char * >(&header), sizeof(header));
+
+	z_stream stream = {};
+	if (deflateInit(&stream, level) != Z_OK) {
+		throw std::runtime_error("Failed to initialize chunk compression");
+	}
+	stream.next_in = const_cast< Bytef * >(reinterpret_cast< Bytef const * >(from.data()));
+	stream.avail_in = uInt(header.uncompressed_size);
+
+	uint32_t compressed_size = 0;
+	char block[16384];
+	int result = Z_OK;
+	while (result != Z_STREAM_END) {
+		stream.next_out = reinterpret_cast< Bytef * >(block);
+		stream.avail_out = sizeof(block);
+		result = deflate(&stream, Z_FINISH);
+		if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+			deflateEnd(&stream);
+			throw std::runtime_error("Failed to compress chunk data.");
+		}
+		uint32_t count = uint32_t(sizeof(block) - stream.avail_out);
+		to.write(block, count);
+		compressed_size += count;
+	}
+	deflateEnd(&stream);
+
+	//pad with zeros (ignored when reading) so the chunks written after this one stay 8-byte aligned:
+	while ((compressed_size + 4) % 8 != 0) {
+		to.put('\0');
+		compressed_size += 1;
+	}
+
+	if (compressed_size + 4 >= CompressedChunkFlag) {
+		throw std::runtime_error("Compressed chunk is too large");
+	}
+	header.size = (compressed_size + 4) | CompressedChunkFlag;
+	std::streampos end = to.tellp();
+	to.seekp(start);
+	to.write(reinterpret_cast< const char * >(&header), sizeof(header));
+	to.seekp(end);
+}
+
+
+//----------------------------------------------------------------
+//Chunk files (version 2), safe to map and read in place:
+// |CH|KF|..|..| <-- four byte file magic "CHKF"
+// |ve|rs|io|n.| <-- four byte version (ChunkFileVersion)
+// |00|00|00|00| * 2 <-- reserved
+//followed by any number of chunks:
+// |ma|gi|c.|..| <-- four byte "magic number"
+// |sz|sz|sz|sz| <-- four byte size of the payload
+// |cr|cr|cr|cr| <-- four byte CRC32 of the payload
+// |00|00|00|00| <-- reserved
+// |TT...TT| * (sz/sizeof(TT)) <-- payload, then zeros up to a multiple of 16 bytes
+//All integers (in headers and payloads) are little-endian and every payload starts 16-byte aligned.
+
+constexpr uint32_t ChunkFileVersion = 2;
+
+//width of the integers making up T, used to byte-swap payloads on big-endian hosts:
+// it is only defined for plain numbers, so every structure written to a chunk file
+// must specialize it (see Sprites.hpp), and one with mixed integer widths doesn't compile.
+template< typename T >
+struct ChunkWordSize;
+
+template< typename T > requires std::is_arithmetic_v< T >
+struct ChunkWordSize< T > {
+	static constexpr size_t value = sizeof(T);
+};
+
+//converts 'count' T structures between little-endian and host order, in place:
+template< typename T >
+void swap_chunk_words(T *data, size_t count) {
+	constexpr size_t Word = ChunkWordSize< T >::value;
+	static_assert(sizeof(T) % Word == 0, "T is made of whole words");
+	if constexpr (std::endian::native != std::endian::little && Word > 1) {
+		uint8_t *bytes = reinterpret_cast< uint8_t * >(data);
+		for (size_t i = 0; i < count * sizeof(T); i += Word) {
+			std::reverse(bytes + i, bytes + i + Word);
+		}
+	}
+}
+
+inline uint32_t load_le32(uint8_t const *bytes) {
+	return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+inline void store_le32(uint32_t value, char *bytes) {
+	bytes[0] = char(value);
+	bytes[1] = char(value >> 8);
+	bytes[2] = char(value >> 16);
+	bytes[3] = char(value >> 24);
+}
+
+//writes the header that starts a chunk file:
+inline void write_chunk_file_header(std::ostream *to_) {
+	assert(to_);
+	char header[16] = {'C', 'H', 'K', 'F'};
+	store_le32(ChunkFileVersion, header + 4);
+	to_->write(header, sizeof(header));
+}
+
+//checks the header that starts a chunk file and advances 'from' to the first chunk:
+//NOTE: throws if the file is not a chunk file or has another version
+inline void read_chunk_file_header(std::span< uint8_t const > &from) {
+	if (from.size() < 16 || std::memcmp(from.data(), "CHKF", 4) != 0) {
+		throw std::runtime_error("Not a chunk file");
+	}
+	uint32_t version = load_le32(from.data() + 4);
+	if (version != ChunkFileVersion) {
+		throw std::runtime_error("Chunk file has version " + std::to_string(version) + ", expected " + std::to_string(ChunkFileVersion));
+	}
+	from = from.subspan(16);
+}
+
+//writes a chunk of a chunk file (after write_chunk_file_header or other chunks):
+template< typename T >
+void write_chunk_v2(std::string const &magic, std::vector< T > const &from, std::ostream *to_) {
+	assert(magic.size() == 4);
+	assert(to_);
+	auto &to = *to_;
+
+	uint32_t size = uint32_t(from.size() * sizeof(T));
+	char const *payload = reinterpret_cast< char const * >(from.data());
+	std::vector< T > swapped;
+	if constexpr (std::endian::native != std::endian::little && ChunkWordSize< T >::value > 1) {
+		swapped = from;
+		swap_chunk_words(swapped.data(), swapped.size());
+		payload = reinterpret_cast< char const * >(swapped.data());
+	}
+
+	char header[16] = {magic[0], magic[1], magic[2], magic[3]};
+	store_le32(size, header + 4);
+	store_le32(uint32_t(crc32(0, reinterpret_cast< Bytef const * >(payload), size)), header + 8);
+
+	to.write(header, sizeof(header));
+	to.write(payload, size);
+	static char const padding[16] = {};
+	to.write(padding, (16 - size % 16) % 16);
+}
+
+//reads (and checks) the header of the chunk at the start of 'from' and returns its payload:
+// 'from' is advanced past the chunk and its padding.
+inline std::span< uint8_t const > read_chunk_v2_payload(std::span< uint8_t const > &from, std::string const &magic) {
+	assert(magic.size() == 4);
+	if (from.size() < 16) {
+		throw std::runtime_error("Failed to read chunk header");
+	}
+	if (std::memcmp(from.data(), magic.data(), 4) != 0) {
+		throw std::runtime_error("Unexpected magic number in chunk (expected '" + magic + "')");
+	}
+	uint32_t size = load_le32(from.data() + 4);
+	uint32_t padded = size + (16 - size % 16) % 16;
+	if (from.size() - 16 < size) {
+		throw std::runtime_error("Chunk '" + magic + "' is truncated");
+	}
+	std::span< uint8_t const > payload = from.subspan(16, size);
+	if (uint32_t(crc32(0, payload.data(), size)) != load_le32(from.data() + 8)) {
+		throw std::runtime_error("Chunk '" + magic + "' is corrupt (CRC mismatch)");
+	}
+	if (reinterpret_cast< uintptr_t >(payload.data()) % 16 != 0) {
+		throw std::runtime_error("Chunk '" + magic + "' is not 16-byte aligned");
+	}
+	from = from.subspan(std::min< size_t >(16 + size_t(padded), from.size()));
+	return payload;
+}
+
+//zero-copy read of a chunk of a chunk file: 'to' points into 'from', which is advanced past the chunk.
+//NOTE: throws on big-endian hosts for multi-byte T, read into a vector there instead
+template< typename T >
+void read_chunk_v2(std::span< uint8_t const > &from, std::string const &magic, std::span< T const > *to_) {
+	assert(to_);
+	static_assert(alignof(T) <= 16, "payloads are 16-byte aligned");
+	if constexpr (std::endian::native != std::endian::little && ChunkWordSize< T >::value > 1) {
+		throw std::runtime_error("Chunk '" + magic + "' needs byte swapping and can't be read in place on this host");
+	}
+	std::span< uint8_t const > payload = read_chunk_v2_payload(from, magic);
+	if (payload.size() % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	*to_ = std::span< T const >(reinterpret_cast< T const * >(payload.data()), payload.size() / sizeof(T));
+}
+
+//reads a chunk of a chunk file into a vector, byte-swapping it in bulk to host order if needed:
+template< typename T >
+void read_chunk_v2(std::span< uint8_t const > &from, std::string const &magic, std::vector< T > *to_) {
+	assert(to_);
+	auto &to = *to_;
+	std::span< uint8_t const > payload = read_chunk_v2_payload(from, magic);
+	if (payload.size() % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	to.resize(payload.size() / sizeof(T));
+	if (!payload.empty()) std::memcpy(to.data(), payload.data(), payload.size());
+	swap_chunk_words(to.data(), to.size());
+}